@@ -8,7 +8,7 @@
 
 AnimationManager::AnimationManager(float squareSize, int tableX, int tableY)
 	: SquareSize(squareSize), Speed(50.0f),
-	  TableX(tableX), TableY(tableY)
+	  TableX(tableX), TableY(tableY), States(2), Palette(PALETTE_FADING)
 {
 	InitRenderData();
 }
@@ -56,7 +56,7 @@ void AnimationManager::DrawSquare(Animation& sq)
 	float StartY = TableY + (float)sq.position.X * SquareSize;
 
 	ResourceManager::GetShader("line").Use();
-	ResourceManager::GetShader("line").SetVector3f("color", glm::vec3(0.0f, 0.0f, 0.0f));
+	ResourceManager::GetShader("line").SetVector3f("color", StateColor(sq.state));
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, glm::vec3(StartX + (SquareSize - sq.scale) / 2.0f, StartY + (SquareSize - sq.scale) / 2.0f, 0.0f));
 	model = glm::scale(model, glm::vec3(sq.scale, sq.scale, 0.0f));
@@ -67,30 +67,63 @@ void AnimationManager::DrawSquare(Animation& sq)
 	glBindVertexArray(0);
 }
 
-void AnimationManager::AddBlock(coordinates sq)
+uint64_t AnimationManager::Key(const coordinates& sq)
 {
-	if (FindBlock(sq) == -1)
-		BlockAnims.push_back(Animation(sq));
+	return ((uint64_t)(uint32_t)sq.X << 32) | (uint32_t)sq.Y;
+}
+
+void AnimationManager::AddBlock(coordinates sq, int state)
+{
+	int element = FindBlock(sq);
+	if (element != -1)
+	{
+		BlockAnims[element].state = state;
+		return;
+	}
+
+	BlockIndex[Key(sq)] = (int)BlockAnims.size();
+	BlockAnims.push_back(Animation(sq, state));
 }
 
 int AnimationManager::FindBlock(coordinates& sq)
 {
-	for (int index = 0; index < BlockAnims.size(); index++)
-		if (BlockAnims[index].position.X == sq.X && BlockAnims[index].position.Y == sq.Y)
-			return index;
-	return -1;
+	auto iter = BlockIndex.find(Key(sq));
+	return (iter == BlockIndex.end()) ? -1 : iter->second;
 }
 
 void AnimationManager::DeleteBlock(coordinates sq)
 {
 	int element = FindBlock(sq);
 	if (element != -1)
-		BlockAnims.erase(BlockAnims.begin() + element);
+		DeleteAt(element);
+}
+
+void AnimationManager::DeleteAt(int index)
+{
+	BlockIndex.erase(Key(BlockAnims[index].position));
+
+	if (index != (int)BlockAnims.size() - 1)
+	{
+		BlockAnims[index] = BlockAnims.back();
+		BlockIndex[Key(BlockAnims[index].position)] = index;
+	}
+	BlockAnims.pop_back();
+}
+
+void AnimationManager::RemoveBlocksOutside(int rowBegin, int rowEnd, int columnBegin, int columnEnd)
+{
+	for (int index = (int)BlockAnims.size() - 1; index >= 0; index--)
+	{
+		const coordinates& sq = BlockAnims[index].position;
+		if (sq.X < rowBegin || sq.X >= rowEnd || sq.Y < columnBegin || sq.Y >= columnEnd)
+			DeleteAt(index);
+	}
 }
 
 void AnimationManager::Reset()
 {
 	BlockAnims.clear();
+	BlockIndex.clear();
 }
 
 void AnimationManager::SetTablePosition(int x, int y)
@@ -104,3 +137,29 @@ void AnimationManager::SetTableSquareSize(float size)
 	SquareSize = size;
 }
 
+void AnimationManager::SetStateCount(int states)
+{
+	States = states;
+}
+
+void AnimationManager::SetPalette(EPalette palette)
+{
+	Palette = palette;
+}
+
+glm::vec3 AnimationManager::StateColor(int state) const
+{
+	if (Palette == PALETTE_WIREWORLD)
+	{
+		static const glm::vec3 WireColors[] = { glm::vec3(1.0f, 0.75f, 0.0f), glm::vec3(0.0f, 0.3f, 1.0f), glm::vec3(0.9f, 0.1f, 0.0f) };
+		return WireColors[std::min(std::max(state, 1), 3) - 1];
+	}
+
+	if (state <= 1)
+		return glm::vec3(0.0f, 0.0f, 0.0f);
+
+	// fading states go from dark red to light orange
+	float t = (States > 3) ? (float)(state - 2) / (float)(States - 3) : 0.0f;
+	return glm::mix(glm::vec3(0.6f, 0.0f, 0.0f), glm::vec3(1.0f, 0.75f, 0.3f), t);
+}
+
@@ -3,20 +3,31 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
-typedef std::pair<unsigned int, unsigned int> coordinates;
+typedef std::pair<int, int> coordinates;
+
+// colors of the cell states
+enum EPalette
+{
+	PALETTE_FADING,			// 1 = black, 2.. = dark red to light orange
+	PALETTE_WIREWORLD		// 1 = conductor, 2 = electron head, 3 = electron tail
+};
 
 struct Animation
 {
-	Animation(coordinates pos)
+	Animation(coordinates pos, int st)
 	{
 		position = pos;
+		state = st;
 	}
 
 	coordinates position;
 	float scale = 1.0f;
+	int state = 1;
 };
 
 class AnimationManager
@@ -25,15 +36,22 @@ public:
 	// constructor
 	AnimationManager(float squareSize, int tableX, int tableY);
 
-	// funtions for adding/removing squares
-	void AddBlock(coordinates sq);
+	// funtions for adding/removing squares, state picks the color (1 = living, 2.. = fading Generations states)
+	void AddBlock(coordinates sq, int state = 1);
 	int FindBlock(coordinates& sq);
 	void DeleteBlock(coordinates sq);
 
+	// delete the squares outside rows [rowBegin, rowEnd) x columns [columnBegin, columnEnd)
+	void RemoveBlocksOutside(int rowBegin, int rowEnd, int columnBegin, int columnEnd);
+
 	// table funtions
 	void SetTablePosition(int x, int y);
 	void SetTableSquareSize(float size);
 
+	// number of cell states, for the color of the fading states
+	void SetStateCount(int states);
+	void SetPalette(EPalette palette);
+
 	// draw
 	void Draw(float deltaTime);
 
@@ -43,9 +61,12 @@ public:
 private:
 	// store all squares that must be animated
 	std::vector<Animation> BlockAnims;
+	std::unordered_map<uint64_t, int> BlockIndex;
 	float SquareSize;
 	float Speed;
 	int TableX, TableY;
+	int States;
+	EPalette Palette;
 
 	// initialize render data
 	void InitRenderData();
@@ -55,5 +76,12 @@ private:
 
 	// draw
 	void DrawSquare(Animation& sq);
+	glm::vec3 StateColor(int state) const;
+
+	// index key of a square
+	static uint64_t Key(const coordinates& sq);
+
+	// delete the square at index, the last square takes its place
+	void DeleteAt(int index);
 };
 
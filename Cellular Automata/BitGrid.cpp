@@ -0,0 +1,767 @@
+#include "BitGrid.h"
+#include "LifeKernels.h"
+#include "LifeRule.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Instantiate static variables
+const uint8_t BitGrid::TILE_EDITED;
+
+BitGrid::BitGrid()
+	: Width(0), Height(0), WordsPerRow(0), Stride(0), LastWordMask(0), Topology(TOPOLOGY_DEAD), Origin(nullptr), TileRows(0), TileColumns(0)
+{
+	Allocate(0, 0);
+}
+
+BitGrid::BitGrid(const BitGrid& other)
+	: Width(0), Height(0), WordsPerRow(0), Stride(0), LastWordMask(0), Topology(TOPOLOGY_DEAD), Origin(nullptr), TileRows(0), TileColumns(0)
+{
+	Allocate(other.Width, other.Height);
+	*this = other;
+}
+
+BitGrid& BitGrid::operator=(const BitGrid& other)
+{
+	if (this == &other)
+		return *this;
+
+	if (Width != other.Width || Height != other.Height)
+		Allocate(other.Width, other.Height);
+
+	// copy data rows with their padding, then the halo around them
+	std::copy(other.Row(0), other.Row(Height), Row(0));
+	TileChanged = other.TileChanged;
+	TileCycled = other.TileCycled;
+	TileBoxes = other.TileBoxes;
+	TileCounts = other.TileCounts;
+	Topology = other.Topology;
+	UpdateHalo();
+	return *this;
+}
+
+void BitGrid::Resize(int width, int height)
+{
+	Allocate(width, height);
+}
+
+void BitGrid::Allocate(int width, int height)
+{
+	Width = std::max(width, 0);
+	Height = std::max(height, 0);
+	WordsPerRow = (Width + 63) / 64;
+
+	// at least one spare word per row, so row[WordsPerRow] is always dead padding
+	Stride = (WordsPerRow + ROW_ALIGNMENT) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+	LastWordMask = (Width % 64 == 0) ? ~0ULL : (1ULL << (Width % 64)) - 1;
+
+	// layout: [slack][guard rows][Height rows][guard rows][slack] + room to align the start
+	size_t words = (size_t)(Height + 2 * GUARD_ROWS) * Stride + 3 * ROW_ALIGNMENT;
+	Storage.assign(words, 0);
+
+	uint64_t* base = Storage.data();
+	while (((uintptr_t)base & (ROW_ALIGNMENT * sizeof(uint64_t) - 1)) != 0)
+		base++;
+
+	Origin = base + ROW_ALIGNMENT + GUARD_ROWS * Stride;
+
+	// a new board has to be stepped everywhere once
+	TileRows = (Height + TILE_ROWS - 1) / TILE_ROWS;
+	TileColumns = (WordsPerRow + TILE_WORDS - 1) / TILE_WORDS;
+	TileChanged.assign((size_t)TileRows * TileColumns, 1);
+	TileCycled.assign((size_t)TileRows * TileColumns, 1);
+	TileBoxes.assign((size_t)TileRows * TileColumns, TileBox{ 0, 0, -1, -1 });
+	TileCounts.assign((size_t)TileRows * TileColumns, TileCount{ 0, 0, 0 });
+}
+
+void BitGrid::Clear()
+{
+	std::fill(Storage.begin(), Storage.end(), 0);
+	std::fill(TileChanged.begin(), TileChanged.end(), 1);
+	std::fill(TileCycled.begin(), TileCycled.end(), TILE_EDITED);
+	std::fill(TileBoxes.begin(), TileBoxes.end(), TileBox{ 0, 0, -1, -1 });
+	std::fill(TileCounts.begin(), TileCounts.end(), TileCount{ 0, 0, 0 });
+}
+
+bool BitGrid::Get(int row, int column) const
+{
+	return (Row(row)[column >> 6] >> (column & 63)) & 1;
+}
+
+void BitGrid::Set(int row, int column, bool alive)
+{
+	uint64_t bit = 1ULL << (column & 63);
+	bool wasAlive = (Row(row)[column >> 6] & bit) != 0;
+	if (alive)
+		Row(row)[column >> 6] |= bit;
+	else
+		Row(row)[column >> 6] &= ~bit;
+
+	int tile = (row / TILE_ROWS) * TileColumns + (column >> 6) / TILE_WORDS;
+	TileChanged[tile] = 1;
+	TileCycled[tile] = TILE_EDITED;
+	TileCounts[tile].Population += (int)alive - (int)wasAlive;
+
+	// a birth grows the box of its tile, a death leaves it as it is until the next step measures it
+	TileBox& box = TileBoxes[tile];
+	if (alive && box.Top > box.Bottom)
+		box = TileBox{ row, column, row, column };
+	else if (alive)
+		box = TileBox{ std::min(box.Top, row), std::min(box.Left, column), std::max(box.Bottom, row), std::max(box.Right, column) };
+
+	if (Topology != TOPOLOGY_DEAD && (row < GUARD_ROWS || row >= Height - GUARD_ROWS || column < GUARD_ROWS || column >= Width - GUARD_ROWS))
+		UpdateHalo();
+}
+
+void BitGrid::SetTopology(ETopology topology)
+{
+	if (topology == Topology)
+		return;
+
+	// the edge tiles see other cells now
+	Topology = topology;
+	std::fill(TileChanged.begin(), TileChanged.end(), 1);
+	std::fill(TileCycled.begin(), TileCycled.end(), TILE_EDITED);
+
+	if (Topology == TOPOLOGY_DEAD)
+	{
+		// clear the old halo, the padding bits of the last words included
+		for (int row = -GUARD_ROWS; row < Height + GUARD_ROWS; row++)
+		{
+			uint64_t* words = Row(row);
+			if (row < 0 || row >= Height)
+				std::fill(words - 1, words + Stride - 1, 0);
+			else
+				words[WordsPerRow - 1] &= LastWordMask;
+			words[WordsPerRow] = 0;
+			words[-1] = 0;
+		}
+	}
+	else
+	{
+		UpdateHalo();
+	}
+}
+
+static const char* TopologyNames[TOPOLOGY_COUNT] = { "dead", "torus", "klein", "mirror" };
+
+const char* BitGrid::GetTopologyName(ETopology topology)
+{
+	return TopologyNames[topology];
+}
+
+bool BitGrid::FindTopology(const std::string& name, ETopology& topology)
+{
+	for (int i = 0; i < TOPOLOGY_COUNT; i++)
+	{
+		if (name == TopologyNames[i])
+		{
+			topology = (ETopology)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool BitGrid::MeasureTile(const BitGrid& previous, int tileRow, int tileColumn)
+{
+	int rowEnd = std::min((tileRow + 1) * TILE_ROWS, Height);
+	int wordBegin = tileColumn * TILE_WORDS;
+	int wordEnd = std::min(wordBegin + TILE_WORDS, WordsPerRow);
+
+	// living and flipped cells, the columns living cells are in and the first and last rows holding any
+	int population = 0, flips = 0;
+	uint64_t columns[TILE_WORDS] = {};
+	int top = -1, bottom = -1;
+	for (int row = tileRow * TILE_ROWS; row < rowEnd; row++)
+	{
+		const uint64_t* words = Row(row);
+		const uint64_t* before = previous.Row(row);
+		uint64_t any = 0;
+		for (int w = wordBegin; w < wordEnd; w++)
+		{
+			// past the right edge is halo
+			uint64_t mask = (w == WordsPerRow - 1) ? LastWordMask : ~0ULL;
+			uint64_t bits = words[w] & mask;
+			population += PopCount(bits);
+			flips += PopCount((bits ^ before[w]) & mask);
+			columns[w - wordBegin] |= bits;
+			any |= bits;
+		}
+
+		if (any != 0)
+		{
+			top = (top < 0) ? row : top;
+			bottom = row;
+		}
+	}
+
+	return StoreTile(previous, tileRow * TileColumns + tileColumn, population, flips, columns, wordBegin, wordEnd, top, bottom);
+}
+
+void BitGrid::MeasureTileRow(const BitGrid& previous, int tileRow)
+{
+	int rowBegin = tileRow * TILE_ROWS;
+	int rowEnd = std::min(rowBegin + TILE_ROWS, Height);
+
+	// same as MeasureTile for all the tiles of the row side by side, read row by row in the order of the words
+	std::vector<int> population(TileColumns, 0), flips(TileColumns, 0), top(TileColumns, -1), bottom(TileColumns, -1);
+	std::vector<uint64_t> columns(WordsPerRow, 0);
+	for (int row = rowBegin; row < rowEnd; row++)
+	{
+		const uint64_t* words = Row(row);
+		const uint64_t* before = previous.Row(row);
+		for (int w = 0; w < WordsPerRow; w++)
+		{
+			// past the right edge is halo
+			uint64_t mask = (w == WordsPerRow - 1) ? LastWordMask : ~0ULL;
+			uint64_t bits = words[w] & mask;
+			int tileColumn = w / TILE_WORDS;
+			population[tileColumn] += PopCount(bits);
+			flips[tileColumn] += PopCount((bits ^ before[w]) & mask);
+			columns[w] |= bits;
+			top[tileColumn] = (top[tileColumn] < 0 && bits != 0) ? row : top[tileColumn];
+			bottom[tileColumn] = (bits != 0) ? row : bottom[tileColumn];
+		}
+	}
+
+	for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+	{
+		int wordBegin = tileColumn * TILE_WORDS;
+		int wordEnd = std::min(wordBegin + TILE_WORDS, WordsPerRow);
+		int tile = tileRow * TileColumns + tileColumn;
+		TileChanged[tile] = StoreTile(previous, tile, population[tileColumn], flips[tileColumn], &columns[wordBegin], wordBegin, wordEnd, top[tileColumn], bottom[tileColumn]);
+	}
+}
+
+bool BitGrid::StoreTile(const BitGrid& previous, int tile, int population, int flips, const uint64_t* columns, int wordBegin, int wordEnd, int top, int bottom)
+{
+	TileBox box{ 0, 0, -1, -1 };
+	for (int w = wordBegin; w < wordEnd; w++)
+	{
+		if (columns[w - wordBegin] == 0)
+			continue;
+
+		int left = w * 64 + CountTrailingZeros(columns[w - wordBegin]);
+		box.Left = (box.Top > box.Bottom) ? left : box.Left;
+		box.Right = w * 64 + HighestBit(columns[w - wordBegin]);
+		box.Top = top;
+		box.Bottom = bottom;
+	}
+
+	// the population of previous is exact: births - deaths is the difference, births + deaths the flips
+	int births = (flips + population - previous.TileCounts[tile].Population) / 2;
+	TileBoxes[tile] = box;
+	TileCounts[tile] = TileCount{ population, births, flips - births };
+	return flips > 0;
+}
+
+bool BitGrid::GetBoundingBox(int& top, int& left, int& bottom, int& right) const
+{
+	bool found = false;
+	for (const TileBox& box : TileBoxes)
+	{
+		if (box.Top > box.Bottom)
+			continue;
+
+		top = found ? std::min(top, box.Top) : box.Top;
+		left = found ? std::min(left, box.Left) : box.Left;
+		bottom = found ? std::max(bottom, box.Bottom) : box.Bottom;
+		right = found ? std::max(right, box.Right) : box.Right;
+		found = true;
+	}
+	return found;
+}
+
+void BitGrid::GetCounts(long long& population, long long& births, long long& deaths) const
+{
+	population = births = deaths = 0;
+	for (const TileCount& count : TileCounts)
+	{
+		population += count.Population;
+		births += count.Births;
+		deaths += count.Deaths;
+	}
+}
+
+void BitGrid::MeasureTiles(const BitGrid& previous)
+{
+	for (int tileRow = 0; tileRow < TileRows; tileRow++)
+		for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+			MeasureTile(previous, tileRow, tileColumn);
+}
+
+void BitGrid::NextGeneration(BitGrid& dst, ThreadPool* pool, bool dstIsPrevious) const
+{
+	// a freshly allocated dst does not hold the quiet tiles yet
+	bool stepAll = false;
+	if (dst.Width != Width || dst.Height != Height)
+	{
+		dst.Allocate(Width, Height);
+		stepAll = true;
+	}
+	bool copyQuiet = !dstIsPrevious && !stepAll;
+	dst.SetTopology(Topology);
+
+	// dst holds the generation before this one, which comes back in tiles that blink
+	bool replay = dstIsPrevious && !stepAll;
+
+	// on dead edges nothing is born past the reach of the living cells: rows and words of the active tiles
+	// outside the bounding box grown by it are cleared instead of stepped
+	int boxRowBegin = 0, boxRowEnd = Height, boxWordBegin = 0, boxWordEnd = WordsPerRow;
+	if (Topology == TOPOLOGY_DEAD)
+	{
+		int reach = LifeKernels::GetRule().GetReach();
+		int top, left, bottom, right;
+		if (GetBoundingBox(top, left, bottom, right))
+		{
+			boxRowBegin = std::max(top - reach, 0);
+			boxRowEnd = std::min(bottom + reach + 1, Height);
+			boxWordBegin = std::max(left - reach, 0) >> 6;
+			boxWordEnd = (std::min(right + reach, Width - 1) >> 6) + 1;
+		}
+		else
+		{
+			boxRowBegin = boxRowEnd = boxWordBegin = boxWordEnd = 0;
+		}
+	}
+
+	// across wrapped edges, the tiles along one edge are next to the tiles along the opposite one
+	bool edgeChanged = false, edgeCycled = false;
+	if (Topology == TOPOLOGY_TORUS || Topology == TOPOLOGY_KLEIN_BOTTLE)
+	{
+		for (int tileRow = 0; tileRow < TileRows; tileRow++)
+		{
+			for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+			{
+				if (!IsEdgeTile(tileRow, tileColumn))
+					continue;
+				edgeChanged = edgeChanged || TileChanged[tileRow * TileColumns + tileColumn];
+				edgeCycled = edgeCycled || TileCycled[tileRow * TileColumns + tileColumn];
+			}
+		}
+	}
+
+	// tiles whose neighbourhood did not change in the last generation are still (TILE_QUIET), the ones whose
+	// neighbourhood is back to what it was two generations ago blink and their next generation is the one dst
+	// holds already (TILE_ASLEEP), the others are stepped (TILE_ACTIVE)
+	std::vector<uint8_t> state((size_t)TileRows * TileColumns, TILE_ACTIVE);
+	int activeTiles = 0;
+
+	for (int tileRow = 0; tileRow < TileRows; tileRow++)
+	{
+		for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+		{
+			bool edge = IsEdgeTile(tileRow, tileColumn);
+			bool changed = stepAll || (edgeChanged && edge);
+			bool cycled = !replay || (edgeCycled && edge);
+			for (int r = std::max(tileRow - 1, 0); r <= std::min(tileRow + 1, TileRows - 1) && !(changed && cycled); r++)
+			{
+				for (int c = std::max(tileColumn - 1, 0); c <= std::min(tileColumn + 1, TileColumns - 1); c++)
+				{
+					changed = changed || TileChanged[r * TileColumns + c] != 0;
+					cycled = cycled || TileCycled[r * TileColumns + c] != 0;
+				}
+			}
+
+			uint8_t tileState = !changed ? TILE_QUIET : !cycled ? TILE_ASLEEP : TILE_ACTIVE;
+			state[tileRow * TileColumns + tileColumn] = tileState;
+			activeTiles += (tileState == TILE_ACTIVE);
+		}
+	}
+
+	// step the runs of active tiles of one tile row, and record which of them changed since the last generation
+	// and since the one before
+	auto stepTileRow = [&](int tileRow) {
+		int rowBegin = tileRow * TILE_ROWS;
+		int rowEnd = std::min(rowBegin + TILE_ROWS, Height);
+		const uint8_t* stateRow = &state[tileRow * TileColumns];
+		uint8_t* changedRow = &dst.TileChanged[tileRow * TileColumns];
+		uint8_t* cycledRow = &dst.TileCycled[tileRow * TileColumns];
+		TileBox* boxRow = &dst.TileBoxes[tileRow * TileColumns];
+		TileCount* countRow = &dst.TileCounts[tileRow * TileColumns];
+
+		// the generation before in the active tiles, about to be overwritten. Taken for the whole tile row before
+		// any run is stepped: the kernels round a run out to whole vectors (8 words for AVX-512), so a run writes
+		// the next generation into the first words of the runs after it as well
+		std::vector<uint64_t> before;
+		if (replay)
+		{
+			before.resize((size_t)(rowEnd - rowBegin) * WordsPerRow);
+			for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+			{
+				if (stateRow[tileColumn] != TILE_ACTIVE)
+					continue;
+
+				int wordBegin = tileColumn * TILE_WORDS;
+				int wordEnd = std::min(wordBegin + TILE_WORDS, WordsPerRow);
+				for (int row = rowBegin; row < rowEnd; row++)
+					std::copy(dst.Row(row) + wordBegin, dst.Row(row) + wordEnd, &before[(size_t)(row - rowBegin) * WordsPerRow + wordBegin]);
+			}
+		}
+
+		for (int tileColumn = 0; tileColumn < TileColumns; )
+		{
+			int wordBegin = tileColumn * TILE_WORDS;
+			if (stateRow[tileColumn] == TILE_QUIET)
+			{
+				// dead in both boards, nothing to copy
+				const TileBox& box = TileBoxes[tileRow * TileColumns + tileColumn];
+				bool empty = box.Top > box.Bottom && boxRow[tileColumn].Top > boxRow[tileColumn].Bottom;
+
+				if (copyQuiet && !empty)
+				{
+					int wordEnd = std::min(wordBegin + TILE_WORDS, WordsPerRow);
+					for (int row = rowBegin; row < rowEnd; row++)
+						std::copy(Row(row) + wordBegin, Row(row) + wordEnd, dst.Row(row) + wordBegin);
+				}
+
+				// dst holds the cells of this generation there, copied or not
+				boxRow[tileColumn] = box;
+				countRow[tileColumn] = TileCount{ TileCounts[tileRow * TileColumns + tileColumn].Population, 0, 0 };
+				changedRow[tileColumn] = 0;
+				cycledRow[tileColumn++] = 0;
+				continue;
+			}
+
+			// nothing to write: it differs from this generation as this one differed from the one before, the cells
+			// born in the last step die and the ones that died are born again
+			if (stateRow[tileColumn] == TILE_ASLEEP)
+			{
+				const TileCount& count = TileCounts[tileRow * TileColumns + tileColumn];
+				countRow[tileColumn].Births = count.Deaths;
+				countRow[tileColumn].Deaths = count.Births;
+				changedRow[tileColumn] = TileChanged[tileRow * TileColumns + tileColumn];
+				cycledRow[tileColumn++] = 0;
+				continue;
+			}
+
+			int runEnd = tileColumn;
+			while (runEnd < TileColumns && stateRow[runEnd] == TILE_ACTIVE)
+				runEnd++;
+			int wordEnd = std::min(runEnd * TILE_WORDS, WordsPerRow);
+
+			// step the part of the run inside the grown bounding box, clear the rest
+			int stepRowBegin = std::max(rowBegin, boxRowBegin), stepRowEnd = std::min(rowEnd, boxRowEnd);
+			int stepWordBegin = std::max(wordBegin, boxWordBegin), stepWordEnd = std::min(wordEnd, boxWordEnd);
+			if (stepRowBegin >= stepRowEnd || stepWordBegin >= stepWordEnd)
+				stepRowBegin = stepRowEnd = rowBegin;
+
+			for (int row = rowBegin; row < rowEnd; row++)
+			{
+				uint64_t* words = dst.Row(row);
+				if (row < stepRowBegin || row >= stepRowEnd)
+				{
+					std::fill(words + wordBegin, words + wordEnd, 0);
+					continue;
+				}
+				std::fill(words + wordBegin, words + stepWordBegin, 0);
+				std::fill(words + stepWordEnd, words + wordEnd, 0);
+			}
+
+			LifeKernels::StepRegion(*this, dst, stepRowBegin, stepRowEnd, stepWordBegin, stepWordEnd);
+
+			for (; tileColumn < runEnd; tileColumn++)
+			{
+				// a tile cleared whole is dead, every cell of this generation there died
+				int population = TileCounts[tileRow * TileColumns + tileColumn].Population;
+				bool cleared = stepRowBegin == stepRowEnd || (tileColumn + 1) * TILE_WORDS <= stepWordBegin || tileColumn * TILE_WORDS >= stepWordEnd;
+				if (cleared)
+				{
+					changedRow[tileColumn] = population > 0;
+					boxRow[tileColumn] = TileBox{ 0, 0, -1, -1 };
+					countRow[tileColumn] = TileCount{ 0, 0, population };
+				}
+				else
+				{
+					changedRow[tileColumn] = dst.MeasureTile(*this, tileRow, tileColumn);
+				}
+				cycledRow[tileColumn] = 1;
+
+				// an edited tile is not the successor of the one dst holds, and neither is its next generation
+				if (!replay || TileCycled[tileRow * TileColumns + tileColumn] == TILE_EDITED)
+					continue;
+
+				bool cycled = false;
+				int tileWordEnd = std::min((tileColumn + 1) * TILE_WORDS, WordsPerRow);
+				for (int row = rowBegin; row < rowEnd && !cycled; row++)
+				{
+					for (int w = tileColumn * TILE_WORDS; w < tileWordEnd; w++)
+					{
+						uint64_t mask = (w == WordsPerRow - 1) ? LastWordMask : ~0ULL;
+						cycled = cycled || ((dst.Row(row)[w] ^ before[(size_t)(row - rowBegin) * WordsPerRow + w]) & mask) != 0;
+					}
+				}
+				cycledRow[tileColumn] = cycled;
+			}
+		}
+	};
+
+	// tile rows only write their own rows of dst, the pool balances them and returns once all are done
+	if (pool == nullptr || pool->GetThreadCount() == 1 || activeTiles * TILE_ROWS * TILE_WORDS < MIN_BAND_WORDS)
+	{
+		for (int tileRow = 0; tileRow < TileRows; tileRow++)
+			stepTileRow(tileRow);
+	}
+	else
+	{
+		pool->Run(TileRows, stepTileRow);
+	}
+
+	dst.UpdateHalo();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Temporal blocking
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BitGrid::NextGenerations(BitGrid& dst, int generations, ThreadPool* pool) const
+{
+	generations = std::max(generations, 1);
+	if (generations == 1 || Topology != TOPOLOGY_DEAD)
+	{
+		// the halo of wrapped and mirrored edges is rewritten from the whole board after every generation, a
+		// block cannot run ahead of it: one generation per pass, through a second board
+		BitGrid between;
+		const BitGrid* from = this;
+		for (int generation = 0; generation < generations; generation++)
+		{
+			// the last generation lands in dst
+			BitGrid& to = ((generations - generation) % 2 == 1) ? dst : between;
+			from->NextGeneration(to, pool);
+			from = &to;
+		}
+
+		// births and deaths of the whole pass
+		if (generations > 1)
+			dst.MeasureTiles(*this);
+		return;
+	}
+
+	if (dst.Width != Width || dst.Height != Height)
+		dst.Allocate(Width, Height);
+	dst.SetTopology(Topology);
+
+	// dst is not compared with the generations before its last one
+	std::fill(dst.TileChanged.begin(), dst.TileChanged.end(), 1);
+	std::fill(dst.TileCycled.begin(), dst.TileCycled.end(), 1);
+
+	// every job steps a run of rows of blocks, with scratch boards of its own; they only write their own rows of dst
+	int blockRows = (Height + TEMPORAL_BLOCK_ROWS - 1) / TEMPORAL_BLOCK_ROWS;
+	int jobCount = (pool == nullptr) ? 1 : std::max(std::min(pool->GetThreadCount(), blockRows), 1);
+
+	auto stepJob = [&](int job) {
+		StepTemporalBlocks(dst, generations, job * blockRows / jobCount, (job + 1) * blockRows / jobCount);
+	};
+
+	if (jobCount <= 1)
+		stepJob(0);
+	else
+		pool->Run(jobCount, stepJob);
+}
+
+void BitGrid::StepTemporalBlocks(BitGrid& dst, int generations, int blockRowBegin, int blockRowEnd) const
+{
+	// a cell farther than the margin from a block cannot reach it in generations steps
+	int reach = LifeKernels::GetRule().GetReach();
+	int margin = generations * reach;
+	int marginWords = (margin + 63) / 64;
+
+	// scratch row i holds row rowBegin - margin + i of the current block, past the edges of the board the rows
+	// stay dead like guard rows; the layout is the one of Allocate
+	int scratchRows = TEMPORAL_BLOCK_ROWS + 2 * margin;
+	size_t boardWords = (size_t)(scratchRows + 2 * GUARD_ROWS) * Stride;
+	std::vector<uint64_t> scratch(2 * boardWords + 3 * ROW_ALIGNMENT, 0);
+
+	uint64_t* base = scratch.data();
+	while (((uintptr_t)base & (ROW_ALIGNMENT * sizeof(uint64_t) - 1)) != 0)
+		base++;
+
+	uint64_t* boards[2] = { base + ROW_ALIGNMENT + GUARD_ROWS * Stride, base + ROW_ALIGNMENT + boardWords + GUARD_ROWS * Stride };
+
+	for (int blockRow = blockRowBegin; blockRow < blockRowEnd; blockRow++)
+	{
+		int rowBegin = blockRow * TEMPORAL_BLOCK_ROWS;
+		int rowEnd = std::min(rowBegin + TEMPORAL_BLOCK_ROWS, Height);
+		int firstRow = rowBegin - margin;
+
+		// the rows past the bottom edge may still hold a block above
+		for (int i = 0; i < scratchRows; i++)
+			if (firstRow + i < 0 || firstRow + i >= Height)
+				for (uint64_t* board : boards)
+					std::fill(board + i * Stride, board + (i + 1) * Stride, 0);
+
+		for (int wordBegin = 0; wordBegin < WordsPerRow; wordBegin += TEMPORAL_BLOCK_WORDS)
+		{
+			int wordEnd = std::min(wordBegin + TEMPORAL_BLOCK_WORDS, WordsPerRow);
+
+			for (int generation = 1; generation <= generations; generation++)
+			{
+				// rows still needed after this generation: the block, and as much margin as the generations left
+				// can reach it from. The words of the margin are stepped whole, what the words around them held
+				// (a block before, or nothing) only spoils the cells the block does not need any more
+				int left = (generations - generation) * reach;
+				int stepBegin = std::max(rowBegin - left, 0);
+				int stepEnd = std::min(rowEnd + left, Height);
+				bool last = (generation == generations);
+
+				const uint64_t* from = (generation == 1) ? Row(stepBegin) : boards[(generation - 1) & 1] + (stepBegin - firstRow) * Stride;
+				uint64_t* to = last ? dst.Row(stepBegin) : boards[generation & 1] + (stepBegin - firstRow) * Stride;
+
+				LifeKernels::StepBuffer(from, to, Stride, WordsPerRow, LastWordMask, stepEnd - stepBegin,
+										last ? wordBegin : std::max(wordBegin - marginWords, 0), last ? wordEnd : std::min(wordEnd + marginWords, WordsPerRow));
+			}
+		}
+
+		// the block is whole tile rows of dst, measured while they are still in cache
+		for (int tileRow = rowBegin / TILE_ROWS; tileRow < (rowEnd + TILE_ROWS - 1) / TILE_ROWS; tileRow++)
+			for (int tileColumn = 0; tileColumn < TileColumns; tileColumn++)
+				dst.MeasureTile(*this, tileRow, tileColumn);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Margolus
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BitGrid::NextBlockGeneration(BitGrid& dst, const MargolusRule& rule, bool odd, ThreadPool* pool) const
+{
+	if (dst.Width != Width || dst.Height != Height)
+		dst.Allocate(Width, Height);
+	dst.SetTopology(Topology);
+	if (Width == 0 || Height == 0)
+		return;
+
+	// next state of a cell of the top or bottom row of a block from itself, the cell beside it, the one in the other
+	// row and the one across, at the even bits for west cells and the odd bits for east ones, see MargolusKernel
+	const uint64_t even = 0x5555555555555555ULL;
+	uint64_t table[32];
+	for (int row = 0; row < 2; row++)
+	{
+		int own = 2 * row, opposite = 2 - 2 * row;
+		for (int entry = 0; entry < 16; entry++)
+		{
+			int self = entry & 1, beside = (entry >> 1) & 1, other = (entry >> 2) & 1, across = (entry >> 3) & 1;
+			int west = (self << own) | (beside << (own + 1)) | (other << opposite) | (across << (opposite + 1));
+			int east = (beside << own) | (self << (own + 1)) | (across << opposite) | (other << (opposite + 1));
+			table[16 * row + entry] = (((rule.Next[west] >> own) & 1) ? even : 0) | (((rule.Next[east] >> (own + 1)) & 1) ? ~even : 0);
+		}
+	}
+
+	// a tile row steps the pairs of rows its blocks span, from row -1 for odd blocks: the blocks across the top and
+	// bottom of the tile row are stepped by the tile rows on both sides, each keeping its own row, then the tiles
+	// are measured while they are still in cache
+	auto stepTileRow = [&](int tileRow) {
+		int rowBegin = tileRow * TILE_ROWS;
+		int rowEnd = std::min(rowBegin + TILE_ROWS, Height);
+		std::vector<uint64_t> scratch(3 * (size_t)(WordsPerRow + 1));
+		uint64_t* spare = &scratch[2 * (size_t)(WordsPerRow + 1)];
+
+		for (int row = odd ? rowBegin - 1 : rowBegin; row < rowEnd; row += 2)
+		{
+			uint64_t* top = (row >= rowBegin) ? dst.Row(row) : spare;
+			uint64_t* bottom = (row + 1 < rowEnd) ? dst.Row(row + 1) : spare;
+			LifeKernels::StepMargolus(table, Row(row), Row(row + 1), top, bottom, scratch.data(), 0, WordsPerRow, odd);
+
+			// columns past the right edge are halo
+			top[WordsPerRow - 1] &= LastWordMask;
+			bottom[WordsPerRow - 1] &= LastWordMask;
+		}
+
+		dst.MeasureTileRow(*this, tileRow);
+		std::fill(&dst.TileCycled[tileRow * TileColumns], &dst.TileCycled[tileRow * TileColumns] + TileColumns, 1);
+	};
+
+	// tile rows only write their own rows of dst
+	if (pool == nullptr || pool->GetThreadCount() == 1 || TileRows * TileColumns * TILE_ROWS * TILE_WORDS < MIN_BAND_WORDS)
+	{
+		for (int tileRow = 0; tileRow < TileRows; tileRow++)
+			stepTileRow(tileRow);
+	}
+	else
+	{
+		pool->Run(TileRows, stepTileRow);
+	}
+
+	dst.UpdateHalo();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Halo
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// cell of a row, column in [-64, Width + 64)
+static inline bool GetBit(const uint64_t* row, int column)
+{
+	return (row[(column + 64) / 64 - 1] >> ((column + 64) % 64)) & 1;
+}
+
+static inline void SetBit(uint64_t* row, int column, bool alive)
+{
+	uint64_t bit = 1ULL << ((column + 64) % 64);
+	if (alive)
+		row[(column + 64) / 64 - 1] |= bit;
+	else
+		row[(column + 64) / 64 - 1] &= ~bit;
+}
+
+// cell of [0, size) shown at index (out of it) by a wrapped or mirrored edge
+static inline int HaloSource(int index, int size, bool mirror)
+{
+	if (!mirror)
+		return (index % size + size) % size;
+
+	index = (index < 0) ? -1 - index : 2 * size - 1 - index;
+	return std::min(std::max(index, 0), size - 1);
+}
+
+bool BitGrid::IsEdgeTile(int tileRow, int tileColumn) const
+{
+	int tileWidth = TILE_WORDS * 64;
+	return tileRow * TILE_ROWS < GUARD_ROWS || (tileRow + 1) * TILE_ROWS > Height - GUARD_ROWS ||
+		   tileColumn * tileWidth < GUARD_ROWS || (tileColumn + 1) * tileWidth > Width - GUARD_ROWS;
+}
+
+void BitGrid::UpdateHalo()
+{
+	if (Topology == TOPOLOGY_DEAD || Width == 0 || Height == 0)
+		return;
+
+	bool mirror = (Topology == TOPOLOGY_MIRROR);
+	int padding = WordsPerRow * 64 - Width;
+
+	// rows past the top and bottom edges
+	for (int i = 0; i < 2 * GUARD_ROWS; i++)
+	{
+		int row = (i < GUARD_ROWS) ? i - GUARD_ROWS : Height + i - GUARD_ROWS;
+		const uint64_t* source = Row(HaloSource(row, Height, mirror));
+		uint64_t* words = Row(row);
+
+		if (Topology == TOPOLOGY_KLEIN_BOTTLE)
+		{
+			// column c = source column Width - 1 - c: reverse the words, then drop the padding they now start with
+			for (int w = 0; w < WordsPerRow; w++)
+			{
+				uint64_t low = ReverseBits(source[WordsPerRow - 1 - w]);
+				uint64_t high = (w + 1 < WordsPerRow) ? ReverseBits(source[WordsPerRow - 2 - w]) : 0;
+				words[w] = (padding == 0) ? low : (low >> padding) | (high << (64 - padding));
+			}
+		}
+		else
+		{
+			std::copy(source, source + WordsPerRow, words);
+		}
+		words[WordsPerRow - 1] &= LastWordMask;
+	}
+
+	// columns past the left and right edges, of the halo rows too for the corners
+	for (int row = -GUARD_ROWS; row < Height + GUARD_ROWS; row++)
+	{
+		uint64_t* words = Row(row);
+		for (int i = 1; i <= GUARD_ROWS; i++)
+		{
+			SetBit(words, -i, GetBit(words, HaloSource(-i, Width, mirror)));
+			SetBit(words, Width - 1 + i, GetBit(words, HaloSource(Width - 1 + i, Width, mirror)));
+		}
+	}
+}
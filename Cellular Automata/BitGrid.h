@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BitOps.h"
+
+class ThreadPool;
+struct MargolusRule;
+
+// what lies past the edges of the board
+enum ETopology
+{
+	TOPOLOGY_DEAD,				// dead cells
+	TOPOLOGY_TORUS,				// the opposite edge
+	TOPOLOGY_KLEIN_BOTTLE,		// the opposite edge, flipped left to right across the top and bottom edges
+	TOPOLOGY_MIRROR,			// the board reflected on the edge
+	TOPOLOGY_COUNT
+};
+
+/*
+
+	Bit-packed board: 64 cells per word, cell (row, column) is bit (column % 64) of word (column / 64). Rows are
+	padded to a multiple of 64 bytes and framed by GUARD_ROWS guard rows, which hold a halo of the cells past the
+	edges for the topology (dead for dead edges), so the step kernels never check bounds.
+
+	The board is split in tiles of TILE_ROWS x TILE_WORDS words, each with whether it changed in the last step,
+	whether it differs from two generations back, the box of its living cells and its counts of living, born
+	and dead cells. NextGeneration steps only the tiles that can change, NextGenerations several generations per
+	pass over memory in cache-sized blocks, NextBlockGeneration the 2x2 blocks of a Margolus rule.
+
+*/
+
+class BitGrid
+{
+public:
+	// constructor
+	BitGrid();
+	BitGrid(const BitGrid& other);
+	BitGrid& operator=(const BitGrid& other);
+
+	// allocate a dead board of the given size
+	void Resize(int width, int height);
+
+	// kill every cell
+	void Clear();
+
+	// cell access
+	bool Get(int row, int column) const;
+	void Set(int row, int column, bool alive);
+
+	// edges of the board, kept by Resize and Clear and passed on to the boards NextGeneration writes
+	void SetTopology(ETopology topology);
+	ETopology GetTopology() const { return Topology; }
+
+	// topology names ("dead", "torus", "klein", "mirror")
+	static const char* GetTopologyName(ETopology topology);
+	static bool FindTopology(const std::string& name, ETopology& topology);
+
+	// board layout
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+	int GetWordsPerRow() const { return WordsPerRow; }
+	int GetStride() const { return Stride; }
+	uint64_t GetLastWordMask() const { return LastWordMask; }
+
+	// rows -GUARD_ROWS .. -1 and Height .. Height + GUARD_ROWS - 1 are valid (dead) guard rows
+	uint64_t* Row(int row) { return Origin + (ptrdiff_t)row * Stride; }
+	const uint64_t* Row(int row) const { return Origin + (ptrdiff_t)row * Stride; }
+
+	// call func(row, column) for every living cell, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const;
+
+	// rows and columns every living cell lies within (inclusive), false if the board is dead
+	bool GetBoundingBox(int& top, int& left, int& bottom, int& right) const;
+
+	// living cells, and the cells born and the ones that died in the step that wrote the board (since the board
+	// before a NextGenerations pass), summed over the tiles
+	void GetCounts(long long& population, long long& births, long long& deaths) const;
+
+	// measure the box and counts of every tile again after cells were written through Row(), births and deaths
+	// against previous
+	void MeasureTiles(const BitGrid& previous);
+
+	// write the next generation of the whole board into dst (B3/S23), with the kernel picked by LifeKernels,
+	// spread over pool when one is given. Quiet tiles are copied, unless dstIsPrevious says dst already
+	// holds the previous generation (then they are equal in both boards and are skipped, and so are the tiles
+	// asleep)
+	void NextGeneration(BitGrid& dst, ThreadPool* pool = nullptr, bool dstIsPrevious = false) const;
+
+	// write generation + generations of the whole board into dst in one pass of temporal blocks, spread over
+	// pool when one is given. Every block is stepped, active or not, and every tile of dst is marked changed.
+	// Boards with wrapped or mirrored edges step generation by generation
+	void NextGenerations(BitGrid& dst, int generations, ThreadPool* pool = nullptr) const;
+
+	// write the next generation of the whole board under a Margolus rule into dst, its blocks starting at odd rows
+	// and columns when odd says so and at even ones otherwise, spread over pool when one is given. Every tile is
+	// stepped
+	void NextBlockGeneration(BitGrid& dst, const MargolusRule& rule, bool odd, ThreadPool* pool = nullptr) const;
+
+	// activity tiles
+	int GetTileRows() const { return TileRows; }
+	int GetTileColumns() const { return TileColumns; }
+	bool IsTileChanged(int tileRow, int tileColumn) const { return TileChanged[tileRow * TileColumns + tileColumn] != 0; }
+	bool IsTileCycled(int tileRow, int tileColumn) const { return TileCycled[tileRow * TileColumns + tileColumn] != 0; }
+
+	// word alignment of every row, in words (64 bytes)
+	static const int ROW_ALIGNMENT = 8;
+
+	// dead rows on each side, as far as a neighbourhood reaches (see LifeRule::GetReach)
+	static const int GUARD_ROWS = 2;
+
+	// tile size: 32 rows x 64 columns
+	static const int TILE_ROWS = 32;
+	static const int TILE_WORDS = 1;
+
+	// least active words before a step is spread over the pool
+	static const int MIN_BAND_WORDS = 2048;
+
+	// part of dst written by one temporal block, 128 rows x 16384 columns (whole tiles and vectors): with 8
+	// generations and their margins a block touches about 630 KB of the scratch boards
+	static const int TEMPORAL_BLOCK_ROWS = 128;
+	static const int TEMPORAL_BLOCK_WORDS = 256;
+
+private:
+	// board size
+	int Width, Height;
+	int WordsPerRow, Stride;
+	uint64_t LastWordMask;
+	ETopology Topology;
+
+	// storage, Origin points at the first word of row 0 and is 64-byte aligned
+	std::vector<uint64_t> Storage;
+	uint64_t* Origin;
+
+	// tiles that changed in the last generation (or were edited), and tiles that differ from two generations back
+	int TileRows, TileColumns;
+	std::vector<uint8_t> TileChanged;
+	std::vector<uint8_t> TileCycled;
+
+	// TileCycled of a tile edited (or cleared, or given new edges) since the last step
+	static const uint8_t TILE_EDITED = 2;
+
+	// cells of a tile every living one lies within, empty when Top > Bottom
+	struct TileBox
+	{
+		int Top, Left, Bottom, Right;
+	};
+	std::vector<TileBox> TileBoxes;
+
+	// living cells of a tile, kept exact by edits, and the births and deaths of the step that wrote it
+	struct TileCount
+	{
+		int Population, Births, Deaths;
+	};
+	std::vector<TileCount> TileCounts;
+
+	// what NextGeneration does with a tile
+	enum ETileState
+	{
+		TILE_ACTIVE,				// stepped
+		TILE_QUIET,					// equal to this generation, copied when dst does not hold it already
+		TILE_ASLEEP					// equal to the generation before, which dst holds
+	};
+
+	void Allocate(int width, int height);
+
+	// box and counts of a tile read from its words with births and deaths against previous, true if it differs
+	bool MeasureTile(const BitGrid& previous, int tileRow, int tileColumn);
+
+	// same for every tile of a tile row, read row by row, and mark the ones that differ changed
+	void MeasureTileRow(const BitGrid& previous, int tileRow);
+
+	// record the box and counts of a tile from what was read of its words, true if any cell flipped
+	bool StoreTile(const BitGrid& previous, int tile, int population, int flips, const uint64_t* columns, int wordBegin, int wordEnd, int top, int bottom);
+
+	// step the temporal blocks of rows of blocks [blockRowBegin, blockRowEnd) generations times into dst
+	void StepTemporalBlocks(BitGrid& dst, int generations, int blockRowBegin, int blockRowEnd) const;
+
+	// rewrite the halo from the cells near the edges
+	void UpdateHalo();
+
+	// whether a tile holds cells the halo is made of
+	bool IsEdgeTile(int tileRow, int tileColumn) const;
+};
+
+template <typename Func>
+void BitGrid::ForEachLiveCell(Func func) const
+{
+	// only the rows and words of the bounding box can hold living cells
+	int top, left, bottom, right;
+	if (!GetBoundingBox(top, left, bottom, right))
+		return;
+
+	for (int row = top; row <= bottom; row++)
+	{
+		const uint64_t* words = Row(row);
+		for (int w = left >> 6; w <= right >> 6; w++)
+		{
+			// the last word also holds the halo past the right edge
+			uint64_t bits = (w == WordsPerRow - 1) ? words[w] & LastWordMask : words[w];
+			while (bits)
+			{
+				func(row, w * 64 + CountTrailingZeros(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+}
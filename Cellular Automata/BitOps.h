@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the lowest set bit (x must not be 0)
+inline int CountTrailingZeros(uint64_t x)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (int)index;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+// index of the highest set bit (x must not be 0)
+inline int HighestBit(uint64_t x)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(x);
+#endif
+}
+
+// bit i of the result is bit 63 - i of x
+inline uint64_t ReverseBits(uint64_t x)
+{
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+	x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+	return (x >> 32) | (x << 32);
+}
+
+// number of set bits, with the popcnt instruction only when the build targets CPUs that have it
+inline int PopCount(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64) && defined(__AVX__)
+	return (int)__popcnt64(x);
+#elif defined(_MSC_VER)
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+#else
+	return __builtin_popcountll(x);
+#endif
+}
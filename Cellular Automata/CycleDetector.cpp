@@ -0,0 +1,194 @@
+#include "CycleDetector.h"
+#include "BitGrid.h"
+#include "SparseUniverse.h"
+
+#include <algorithm>
+
+// key bases, odd so they can be inverted mod 2^64
+static const uint64_t ROW_BASE = 0x9E3779B97F4A7C15ULL;
+static const uint64_t COLUMN_BASE = 0xC2B2AE3D27D4EB4FULL;
+
+// inverse of an odd number mod 2^64, Newton's iteration doubles the correct bits every round
+static uint64_t Inverse(uint64_t odd)
+{
+	uint64_t inverse = odd;
+	for (int round = 0; round < 5; round++)
+		inverse *= 2 - odd * inverse;
+	return inverse;
+}
+
+// base^exponent mod 2^64, negative exponents through the inverse
+static uint64_t Power(uint64_t base, int64_t exponent)
+{
+	if (exponent < 0)
+	{
+		base = Inverse(base);
+		exponent = -exponent;
+	}
+
+	uint64_t result = 1;
+	for (; exponent > 0; exponent >>= 1)
+	{
+		if (exponent & 1)
+			result *= base;
+		base *= base;
+	}
+	return result;
+}
+
+CycleDetector::CycleDetector()
+	: Translations(false), Hashed(false), Hash(0), CycleStart(0), Period(0), RowShift(0), ColumnShift(0)
+{
+
+}
+
+void CycleDetector::Reset()
+{
+	Hashed = false;
+	History.clear();
+	CycleStart = Period = 0;
+	RowShift = ColumnShift = 0;
+}
+
+void CycleDetector::SetTranslations(bool translations)
+{
+	if (translations != Translations)
+		Reset();
+	Translations = translations;
+}
+
+bool CycleDetector::Update(const BitGrid& board, const BitGrid* previous, long long generation)
+{
+	int width = board.GetWidth(), height = board.GetHeight();
+	if ((int)RowKeys.size() != height || (int)ColumnKeys.size() != width)
+	{
+		RowKeys.resize(height);
+		ColumnKeys.resize(width);
+		for (int row = 0; row < height; row++)
+			RowKeys[row] = row ? RowKeys[row - 1] * ROW_BASE : 1;
+		for (int column = 0; column < width; column++)
+			ColumnKeys[column] = column ? ColumnKeys[column - 1] * COLUMN_BASE : 1;
+		Hashed = false;
+	}
+
+	// top left corner of the pattern, only needed to compare shifted states
+	int top = height, left = width;
+	if (!Hashed || previous == nullptr)
+	{
+		Hash = 0;
+		board.ForEachLiveCell([this, &top, &left](int row, int column) {
+			Hash += RowKeys[row] * ColumnKeys[column];
+			top = std::min(top, row);
+			left = std::min(left, column);
+		});
+		Hashed = true;
+	}
+	else
+	{
+		// flips of the tiles that changed, the halo past the right edge left out
+		int wordsPerRow = board.GetWordsPerRow();
+		for (int tileRow = 0; tileRow < board.GetTileRows(); tileRow++)
+		{
+			for (int tileColumn = 0; tileColumn < board.GetTileColumns(); tileColumn++)
+			{
+				if (!board.IsTileChanged(tileRow, tileColumn))
+					continue;
+
+				int rowEnd = std::min((tileRow + 1) * BitGrid::TILE_ROWS, height);
+				int wordEnd = std::min((tileColumn + 1) * BitGrid::TILE_WORDS, wordsPerRow);
+				for (int row = tileRow * BitGrid::TILE_ROWS; row < rowEnd; row++)
+				{
+					const uint64_t* now = board.Row(row);
+					const uint64_t* before = previous->Row(row);
+					for (int w = tileColumn * BitGrid::TILE_WORDS; w < wordEnd; w++)
+					{
+						uint64_t flips = now[w] ^ before[w];
+						if (w == wordsPerRow - 1)
+							flips &= board.GetLastWordMask();
+
+						while (flips)
+						{
+							int column = w * 64 + CountTrailingZeros(flips);
+							uint64_t key = RowKeys[row] * ColumnKeys[column];
+							Hash += ((now[w] >> (column & 63)) & 1) ? key : (uint64_t)0 - key;
+							flips &= flips - 1;
+						}
+					}
+				}
+			}
+		}
+
+		// the step measured the boxes of the tiles it wrote, edits may leave them larger (hashed from scratch above)
+		int bottom, right;
+		if (Translations)
+			board.GetBoundingBox(top, left, bottom, right);
+	}
+
+	if (!Translations)
+		top = left = 0;
+
+	return Record(generation, top, left);
+}
+
+bool CycleDetector::Update(const SparseUniverse& board, long long generation)
+{
+	uint64_t rowKeys[SparseUniverse::TILE_SIZE], columnKeys[SparseUniverse::TILE_SIZE];
+	for (int i = 0; i < SparseUniverse::TILE_SIZE; i++)
+	{
+		rowKeys[i] = i ? rowKeys[i - 1] * ROW_BASE : 1;
+		columnKeys[i] = i ? columnKeys[i - 1] * COLUMN_BASE : 1;
+	}
+
+	int64_t top = INT64_MAX, left = INT64_MAX;
+	Hash = 0;
+	board.ForEachTile([&](int64_t tileRow, int64_t tileColumn, const uint64_t* rows) {
+		uint64_t tileKey = Power(ROW_BASE, tileRow * SparseUniverse::TILE_SIZE) * Power(COLUMN_BASE, tileColumn * SparseUniverse::TILE_SIZE);
+		for (int r = 0; r < SparseUniverse::TILE_SIZE; r++)
+		{
+			uint64_t bits = rows[r];
+			if (bits == 0)
+				continue;
+
+			top = std::min(top, tileRow * SparseUniverse::TILE_SIZE + r);
+			left = std::min(left, tileColumn * SparseUniverse::TILE_SIZE + CountTrailingZeros(bits));
+
+			uint64_t rowKey = tileKey * rowKeys[r];
+			while (bits)
+			{
+				Hash += rowKey * columnKeys[CountTrailingZeros(bits)];
+				bits &= bits - 1;
+			}
+		}
+	});
+	Hashed = false;
+
+	if (top == INT64_MAX)
+		top = left = 0;
+	return Record(generation, Translations ? top : 0, Translations ? left : 0);
+}
+
+bool CycleDetector::Record(long long generation, int64_t top, int64_t left)
+{
+	// the hash of the pattern moved to the origin
+	uint64_t key = Hash;
+	if (Translations)
+		key *= Power(ROW_BASE, -top) * Power(COLUMN_BASE, -left);
+
+	auto iter = History.find(key);
+	if (iter != History.end())
+	{
+		if (Period == 0)
+		{
+			CycleStart = iter->second.Generation;
+			Period = generation - iter->second.Generation;
+			RowShift = top - iter->second.Top;
+			ColumnShift = left - iter->second.Left;
+		}
+		return true;
+	}
+
+	if (History.size() >= MAX_HISTORY)
+		History.clear();
+	History.emplace(key, State{ generation, top, left });
+	return false;
+}
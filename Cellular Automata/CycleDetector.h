@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class BitGrid;
+class SparseUniverse;
+
+/*
+
+	Loop detection for the Life-like boards: a hash of the board kept up to date from the cells that flip every
+	generation, and a table from every hash seen to the generation it was seen at, so a board that comes back
+	to an earlier state is caught on the first generation of its second round, with the period of the loop.
+
+	The hash is a Zobrist hash whose keys follow translations: the key of cell (row, column) is X^row * Y^column
+	(mod 2^64, X and Y odd), and the keys of the living cells are added instead of xored, so a flip adds or
+	subtracts the key of its cell. A pattern shifted by (dr, dc) has its hash multiplied by X^dr * Y^dc, and
+	the hash divided by the key of the top left corner of the pattern is the same wherever the pattern is: a
+	spaceship is caught like an oscillator, with the displacement of one period. Where a shifted pattern does
+	not behave the same (near the edges of a bounded board other than a torus) only repeats in place count.
+
+	On the bounded board only the tiles marked changed are compared with the previous generation, so the cost
+	of a generation follows the activity like the step itself.
+
+*/
+
+class CycleDetector
+{
+public:
+	// constructor
+	CycleDetector();
+
+	// forget every state seen (after edits), the next Update hashes the whole board
+	void Reset();
+
+	// whether a repeat may be shifted, for boards where a shifted pattern evolves the same
+	void SetTranslations(bool translations);
+	bool GetTranslations() const { return Translations; }
+
+	// record board at generation, true if it repeats an earlier state. previous is the board of the last Update
+	// (its tiles not marked changed on board equal in both) to hash only the flips, or nullptr to hash it all
+	bool Update(const BitGrid& board, const BitGrid* previous, long long generation);
+
+	// same for the unbounded board, hashed from scratch (the tiles of the previous generation are gone)
+	bool Update(const SparseUniverse& board, long long generation);
+
+	// first repeat since the last Reset: generation the loop was first seen at, its period and its displacement
+	// per period
+	bool HasCycle() const { return Period > 0; }
+	long long GetCycleStart() const { return CycleStart; }
+	long long GetPeriod() const { return Period; }
+	int64_t GetRowShift() const { return RowShift; }
+	int64_t GetColumnShift() const { return ColumnShift; }
+
+	// states remembered at most, the table starts over once it is full
+	static const size_t MAX_HISTORY = 1 << 20;
+
+private:
+	bool Translations;
+
+	// sum of the keys of the living cells, valid with Hashed
+	bool Hashed;
+	uint64_t Hash;
+
+	// X^row and Y^column on the bounded board
+	std::vector<uint64_t> RowKeys, ColumnKeys;
+
+	struct State
+	{
+		long long Generation;
+		int64_t Top, Left;
+	};
+	std::unordered_map<uint64_t, State> History;
+
+	long long CycleStart, Period;
+	int64_t RowShift, ColumnShift;
+
+	// look up the state with its top left corner, then remember it
+	bool Record(long long generation, int64_t top, int64_t left);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+class ThreadPool;
+struct MargolusRule;
+
+/*
+
+	Front/back pair of boards: the next generation of the front board is written into the back board and
+	the two swap roles, so a step never copies a board.
+
+	After a swap the back board holds the previous generation, and every cell of a tile that is not marked
+	changed in the front board is equal in both. NextGeneration is told so and leaves those tiles alone;
+	every other cell of the back board is written by each step. After a step of several generations the back
+	board is older than that, so the next step writes all of it again.
+
+*/
+
+template <typename Grid>
+class DoubleBuffer
+{
+public:
+	// constructor
+	DoubleBuffer()
+		: Current(0), BackIsPrevious(true)
+	{
+
+	}
+
+	// board shown and edited / board the next generation is written into
+	Grid& Front() { return Buffers[Current]; }
+	const Grid& Front() const { return Buffers[Current]; }
+	Grid& Back() { return Buffers[Current ^ 1]; }
+	const Grid& Back() const { return Buffers[Current ^ 1]; }
+
+	void Swap() { Current ^= 1; }
+
+	// allocate both boards dead
+	void Resize(int width, int height)
+	{
+		Buffers[0].Resize(width, height);
+		Buffers[1].Resize(width, height);
+		BackIsPrevious = true;
+	}
+
+	// kill every cell of both boards
+	void Clear()
+	{
+		Buffers[0].Clear();
+		Buffers[1].Clear();
+		BackIsPrevious = true;
+	}
+
+	// advance the front board one generation, or several in one pass (see BitGrid::NextGenerations)
+	void Step(ThreadPool* pool = nullptr, int generations = 1)
+	{
+		if (generations > 1)
+			Front().NextGenerations(Back(), generations, pool);
+		else
+			Front().NextGeneration(Back(), pool, BackIsPrevious);
+
+		BackIsPrevious = (generations <= 1);
+		Swap();
+	}
+
+	// advance the front board one generation under a Margolus rule (see BitGrid::NextBlockGeneration), which marks
+	// every tile as differing from two generations back
+	void StepBlocks(const MargolusRule& rule, bool odd, ThreadPool* pool = nullptr)
+	{
+		Front().NextBlockGeneration(Back(), rule, odd, pool);
+		BackIsPrevious = true;
+		Swap();
+	}
+
+private:
+	Grid Buffers[2];
+	int Current;
+
+	// whether the back board holds the generation before the front one
+	bool BackIsPrevious;
+};
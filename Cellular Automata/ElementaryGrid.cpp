@@ -0,0 +1,112 @@
+#include "ElementaryGrid.h"
+#include "LifeKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ElementaryGrid::ElementaryGrid()
+	: Width(0), Height(0), WordsPerRow(0), Wrapped(false), HistoryRows(0), Generation(0)
+{
+
+}
+
+void ElementaryGrid::Resize(int width, int height)
+{
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	WordsPerRow = (Width + 63) / 64;
+
+	// a step needs a row to read and another one to write
+	HistoryRows = std::max(Height, 2);
+	History.assign((size_t)HistoryRows * WordsPerRow, 0);
+	Generation = 0;
+}
+
+void ElementaryGrid::Clear()
+{
+	std::fill(History.begin(), History.end(), 0);
+	Generation = 0;
+}
+
+bool ElementaryGrid::Get(int row, int column) const
+{
+	if (row < 0 || row > GetCurrentRow())
+		return false;
+
+	return ((GenerationRow(FirstVisibleGeneration() + row)[column >> 6] >> (column & 63)) & 1) != 0;
+}
+
+void ElementaryGrid::Set(int column, bool alive)
+{
+	uint64_t& word = GenerationRow(Generation)[column >> 6];
+	uint64_t bit = 1ULL << (column & 63);
+	word = alive ? (word | bit) : (word & ~bit);
+}
+
+void ElementaryGrid::NextGeneration(ThreadPool* pool)
+{
+	const uint64_t* src = GenerationRow(Generation);
+	uint64_t* dst = GenerationRow(Generation + 1);
+
+	int jobCount = (WordsPerRow + WORDS_PER_JOB - 1) / WORDS_PER_JOB;
+
+	// jobs only write their own words of the next row
+	auto stepJob = [&](int job) {
+		StepWords(src, dst, job * WORDS_PER_JOB, std::min((job + 1) * WORDS_PER_JOB, WordsPerRow));
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || jobCount <= 1)
+	{
+		for (int job = 0; job < jobCount; job++)
+			stepJob(job);
+	}
+	else
+	{
+		pool->Run(jobCount, stepJob);
+	}
+
+	Generation++;
+}
+
+void ElementaryGrid::StepWords(const uint64_t* src, uint64_t* dst, int begin, int end) const
+{
+	// truth table entry 4 * left + 2 * center + right as a mask
+	uint64_t table[8];
+	for (int entry = 0; entry < 8; entry++)
+		table[entry] = ((Rule.Number >> entry) & 1) ? ~0ULL : 0;
+
+	int last = WordsPerRow - 1;
+	int tail = Width & 63;
+
+	// cells past the ends of the row
+	uint64_t leftOfFirst = Wrapped ? (src[last] >> ((Width - 1) & 63)) & 1 : 0;
+	uint64_t rightOfLast = Wrapped ? src[0] & 1 : 0;
+
+	auto stepEdgeWord = [&](int w) {
+		uint64_t center = src[w];
+		uint64_t previous = (w > 0) ? src[w - 1] : leftOfFirst << 63;
+		uint64_t next = (w < last) ? src[w + 1] : (tail ? 0 : rightOfLast);
+
+		// the cell right of the last one sits inside the last word, cells past it stay dead
+		if (w == last && tail)
+			center |= rightOfLast << tail;
+
+		// the kernel reads its neighbour words, copies of them stand in for the cells past the ends
+		uint64_t words[3] = { previous, center, next };
+		LifeKernels::StepElementary(table, words + 1, dst + w, 0, 1);
+		if (w == last && tail)
+			dst[w] &= (1ULL << tail) - 1;
+	};
+
+	if (begin == 0)
+		stepEdgeWord(0);
+
+	// whole vectors on the selected instruction set
+	int innerBegin = std::max(begin, 1);
+	int innerEnd = std::min(end, last);
+	if (innerBegin < innerEnd)
+		LifeKernels::StepElementary(table, src, dst, innerBegin, innerEnd);
+
+	if (last > 0 && begin <= last && last < end)
+		stepEdgeWord(last);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BitOps.h"
+#include "LifeRule.h"
+
+class ThreadPool;
+
+/*
+
+	Board of an elementary rule (see ElementaryRule), drawn as a space-time diagram: the row of cells is one
+	line of the board and every generation is written on the line below the previous one, so the board shows
+	the last Height generations, scrolling up once it is full.
+
+	A row is a bit vector, 64 cells per word. A step lines up the left and right neighbours of 64 cells with
+	two shifts (plus the bit carried over from the next word) and evaluates the rule as a bitwise multiplexer
+	over the three words, with the 8 entries of its truth table as all-zero/all-one masks, so each word costs
+	a few dozen instructions whatever the rule and a step streams the row through memory once. The words
+	away from the ends go through the SIMD kernel LifeKernels selected, a whole vector at a time.
+
+	The lines of the board are a ring of rows: a step reads the newest row and writes the next one in place of
+	the oldest, no row is ever copied. The ends of the row are dead, or wrapped around.
+
+*/
+
+class ElementaryGrid
+{
+public:
+	// constructor
+	ElementaryGrid();
+
+	// allocate a dead row of width cells, showing height generations
+	void Resize(int width, int height);
+
+	// kill every cell and go back to generation 0
+	void Clear();
+
+	void SetRule(const ElementaryRule& rule) { Rule = rule; }
+	const ElementaryRule& GetRule() const { return Rule; }
+
+	// cells past the ends of the row are dead, or the ends wrap around
+	void SetWrapped(bool wrapped) { Wrapped = wrapped; }
+	bool IsWrapped() const { return Wrapped; }
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+	long long GetGeneration() const { return Generation; }
+
+	// line of the board holding the current generation
+	int GetCurrentRow() const { return (int)(Generation - FirstVisibleGeneration()); }
+
+	// cell of a line of the board, dead below the current generation
+	bool Get(int row, int column) const;
+
+	// edit the current generation
+	void Set(int column, bool alive);
+
+	// advance one generation, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column) for every living cell on the board, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const;
+
+	// call func(row, column) for every living cell of one line of the board
+	template <typename Func>
+	void ForEachLiveCellInRow(int row, Func func) const;
+
+	// words stepped by one job
+	static const int WORDS_PER_JOB = 4096;
+
+private:
+	ElementaryRule Rule;
+
+	int Width, Height;
+	int WordsPerRow;
+	bool Wrapped;
+
+	// ring of HistoryRows rows, generation g lives in row g % HistoryRows
+	int HistoryRows;
+	std::vector<uint64_t> History;
+	long long Generation;
+
+	long long FirstVisibleGeneration() const { return Generation >= Height ? Generation - Height + 1 : 0; }
+
+	uint64_t* GenerationRow(long long generation) { return &History[(size_t)(generation % HistoryRows) * WordsPerRow]; }
+	const uint64_t* GenerationRow(long long generation) const { return &History[(size_t)(generation % HistoryRows) * WordsPerRow]; }
+
+	// write words [begin, end) of the next generation of src into dst
+	void StepWords(const uint64_t* src, uint64_t* dst, int begin, int end) const;
+};
+
+template <typename Func>
+void ElementaryGrid::ForEachLiveCell(Func func) const
+{
+	for (int row = 0; row <= GetCurrentRow(); row++)
+		ForEachLiveCellInRow(row, func);
+}
+
+template <typename Func>
+void ElementaryGrid::ForEachLiveCellInRow(int row, Func func) const
+{
+	if (row < 0 || row > GetCurrentRow())
+		return;
+
+	const uint64_t* words = GenerationRow(FirstVisibleGeneration() + row);
+	for (int w = 0; w < WordsPerRow; w++)
+	{
+		uint64_t bits = words[w];
+		while (bits)
+		{
+			func(row, w * 64 + CountTrailingZeros(bits));
+			bits &= bits - 1;
+		}
+	}
+}
@@ -0,0 +1,216 @@
+#include "EnsembleGrid.h"
+#include "BitGrid.h"
+#include "BitOps.h"
+#include "LifeKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <random>
+
+EnsembleGrid::EnsembleGrid()
+	: BoardCount(0), Width(0), Height(0), GroupCount(0), RowStride(0), Current(0), Generation(0), RunningCount(0)
+{
+
+}
+
+void EnsembleGrid::Resize(int boardCount, int width, int height)
+{
+	BoardCount = std::max(boardCount, 1);
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	GroupCount = (BoardCount + 63) / 64;
+	RowStride = (ptrdiff_t)(Width + 2 * GUARD_CELLS) * GroupCount;
+
+	size_t words = (size_t)(Height + 2 * GUARD_CELLS) * RowStride;
+	Buffers[0].assign(words, 0);
+	Buffers[1].assign(words, 0);
+	Current = 0;
+	Generation = 0;
+	ResetTracking();
+}
+
+void EnsembleGrid::Clear()
+{
+	std::fill(Buffers[0].begin(), Buffers[0].end(), 0);
+	std::fill(Buffers[1].begin(), Buffers[1].end(), 0);
+	Generation = 0;
+	ResetTracking();
+}
+
+void EnsembleGrid::ResetTracking()
+{
+	// boards past the last one never run
+	Settled.assign(GroupCount, 0);
+	if (BoardCount % 64 != 0)
+		Settled[GroupCount - 1] = ~0ULL << (BoardCount % 64);
+
+	SettledGeneration.assign(BoardCount, -1);
+	SettledPeriod.assign(BoardCount, 0);
+	RunningCount = BoardCount;
+
+	Changed.assign(GroupCount, ~0ULL);
+	Cycled.assign(GroupCount, ~0ULL);
+}
+
+void EnsembleGrid::Set(int board, int row, int column, bool alive)
+{
+	uint64_t& word = Slot(Current, row, column)[board >> 6];
+	uint64_t bit = 1ULL << (board & 63);
+	word = alive ? (word | bit) : (word & ~bit);
+
+	// later edits of the same setup are free
+	if (Generation != 0)
+	{
+		Generation = 0;
+		ResetTracking();
+	}
+}
+
+void EnsembleGrid::Randomize(uint64_t seed, double density)
+{
+	std::mt19937_64 random(seed);
+	int level = (int)std::min(std::max(density * 256.0 + 0.5, 0.0), 256.0);
+	uint64_t lastGroupMask = (BoardCount % 64 != 0) ? (1ULL << (BoardCount % 64)) - 1 : ~0ULL;
+
+	for (int row = 0; row < Height; row++)
+	{
+		for (int column = 0; column < Width; column++)
+		{
+			uint64_t* slot = Slot(Current, row, column);
+			for (int g = 0; g < GroupCount; g++)
+			{
+				// one random word per binary digit of level / 256, lowest first: each halves the odds of the
+				// bits so far and adds 1/2 where the digit is set
+				uint64_t bits = (level == 256) ? ~0ULL : 0;
+				for (int digit = 0; digit < 8 && level < 256; digit++)
+					bits = ((level >> digit) & 1) ? (bits | random()) : (bits & random());
+
+				slot[g] = (g == GroupCount - 1) ? bits & lastGroupMask : bits;
+			}
+		}
+	}
+
+	Generation = 0;
+	ResetTracking();
+}
+
+bool EnsembleGrid::IsChunkSettled(int chunk) const
+{
+	for (int g = chunk * CHUNK_GROUPS; g < std::min((chunk + 1) * CHUNK_GROUPS, GroupCount); g++)
+		if (Settled[g] != ~0ULL)
+			return false;
+	return true;
+}
+
+void EnsembleGrid::NextGeneration(ThreadPool* pool)
+{
+	const uint64_t* src = Slot(Current, 0, 0);
+	uint64_t* dst = Slot(Current ^ 1, 0, 0);
+
+	// a settled chunk holds its two alternating generations in the two buffers already, the swap below is its step
+	int chunkCount = (GroupCount + CHUNK_GROUPS - 1) / CHUNK_GROUPS;
+	std::vector<uint8_t> skipped(chunkCount);
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+		skipped[chunk] = IsChunkSettled(chunk);
+
+	// chunks only write their own words of the slots
+	auto stepChunk = [&](int chunk) {
+		if (!skipped[chunk])
+			LifeKernels::StepEnsemble(src, dst, RowStride, GroupCount, Width, Height, chunk * CHUNK_GROUPS, std::min((chunk + 1) * CHUNK_GROUPS, GroupCount), Changed.data(), Cycled.data());
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || chunkCount <= 1)
+	{
+		for (int chunk = 0; chunk < chunkCount; chunk++)
+			stepChunk(chunk);
+	}
+	else
+	{
+		pool->Run(chunkCount, stepChunk);
+	}
+
+	Current ^= 1;
+	Generation++;
+
+	// boards equal to the generation before (still) or two before (period 2, once the other buffer held one)
+	for (int g = 0; g < GroupCount; g++)
+	{
+		uint64_t still = ~Changed[g];
+		uint64_t cycle = (Generation >= 2) ? ~Cycled[g] : 0;
+		uint64_t settled = (still | cycle) & ~Settled[g];
+		Settled[g] |= settled;
+
+		while (settled)
+		{
+			int bit = CountTrailingZeros(settled);
+			int board = g * 64 + bit;
+			SettledPeriod[board] = ((still >> bit) & 1) ? 1 : 2;
+			SettledGeneration[board] = Generation - SettledPeriod[board];
+			RunningCount--;
+			settled &= settled - 1;
+		}
+	}
+}
+
+long long EnsembleGrid::Run(long long maxGenerations, ThreadPool* pool)
+{
+	long long generations = 0;
+	while (RunningCount > 0 && generations < maxGenerations)
+	{
+		NextGeneration(pool);
+		generations++;
+	}
+	return generations;
+}
+
+int EnsembleGrid::GetPopulation(int board) const
+{
+	int population = 0;
+	for (int row = 0; row < Height; row++)
+		for (int column = 0; column < Width; column++)
+			population += Get(board, row, column);
+	return population;
+}
+
+void EnsembleGrid::GetPopulations(std::vector<int>& populations) const
+{
+	populations.assign(BoardCount, 0);
+
+	int planeCount = 1;
+	while ((1LL << planeCount) <= (long long)Width * Height)
+		planeCount++;
+
+	// bit-sliced counters of the 64 boards of a group, one increment per cell
+	std::vector<uint64_t> planes(planeCount);
+	for (int g = 0; g < GroupCount; g++)
+	{
+		std::fill(planes.begin(), planes.end(), 0);
+		for (int row = 0; row < Height; row++)
+		{
+			for (int column = 0; column < Width; column++)
+			{
+				uint64_t carry = Slot(Current, row, column)[g];
+				for (int plane = 0; plane < planeCount && carry; plane++)
+				{
+					uint64_t next = planes[plane] & carry;
+					planes[plane] ^= carry;
+					carry = next;
+				}
+			}
+		}
+
+		for (int bit = 0; bit < 64 && g * 64 + bit < BoardCount; bit++)
+			for (int plane = 0; plane < planeCount; plane++)
+				populations[g * 64 + bit] += (int)((planes[plane] >> bit) & 1) << plane;
+	}
+}
+
+void EnsembleGrid::CopyBoard(int board, BitGrid& grid) const
+{
+	if (grid.GetWidth() != Width || grid.GetHeight() != Height)
+		grid.Resize(Width, Height);
+
+	for (int row = 0; row < Height; row++)
+		for (int column = 0; column < Width; column++)
+			grid.Set(row, column, Get(board, row, column));
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BitGrid;
+class ThreadPool;
+
+/*
+
+	Ensemble of small independent boards of the same size, stepped in lockstep under the Life-like rule of
+	LifeKernels: a batch API for sweeps over many random soups, next to the single interactive board.
+
+	The boards are bit-sliced across words: every cell has a slot of GroupCount words, and bit i of word g of a
+	slot is that cell on board 64 * g + i. A step is then the bitwise kernel of a single board with whole words
+	for neighbours (see EnsembleKernel in LifeKernelTemplate.h), each word stepping a cell of 64 boards, and a
+	vector of the selected instruction set 256 (AVX2) or 512 (AVX-512) of them. The slots of a frame of
+	GUARD_CELLS cells around the boards are always dead, so no cell needs a bounds check.
+
+	Every step also tells, per board, whether its next generation differs from the current one and from the
+	one before: a board equal to one of them has settled into a still life or a period 2 oscillator (an empty
+	board is a still life) and never changes again. Groups of CHUNK_GROUPS words whose boards have all settled
+	are not stepped any more; their two buffers already hold the two generations they alternate between.
+
+*/
+
+class EnsembleGrid
+{
+public:
+	// constructor
+	EnsembleGrid();
+
+	// allocate boardCount dead boards of width x height cells
+	void Resize(int boardCount, int width, int height);
+
+	// kill every cell of every board and go back to generation 0
+	void Clear();
+
+	int GetBoardCount() const { return BoardCount; }
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+	long long GetGeneration() const { return Generation; }
+
+	// cell access, an edit goes back to generation 0 where no board has settled
+	bool Get(int board, int row, int column) const { return ((Slot(Current, row, column)[board >> 6] >> (board & 63)) & 1) != 0; }
+	void Set(int board, int row, int column, bool alive);
+
+	// random soup on every board, each cell alive with probability density (rounded to 1/256), same seed same soups
+	void Randomize(uint64_t seed, double density);
+
+	// advance every board that has not settled one generation, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// step until every board settled or maxGenerations generations ran, returns the generations run
+	long long Run(long long maxGenerations, ThreadPool* pool = nullptr);
+
+	// termination tracking: generation from which a board repeats (-1 while it runs) and its period (1 or 2)
+	bool IsSettled(int board) const { return SettledGeneration[board] >= 0; }
+	long long GetSettledGeneration(int board) const { return SettledGeneration[board]; }
+	int GetSettledPeriod(int board) const { return SettledPeriod[board]; }
+	int GetRunningCount() const { return RunningCount; }
+
+	// living cells of one board, or of all of them at once (one pass over the ensemble)
+	int GetPopulation(int board) const;
+	void GetPopulations(std::vector<int>& populations) const;
+
+	// copy one board into a bounded board, to show it or step it on its own
+	void CopyBoard(int board, BitGrid& grid) const;
+
+	// dead cells around every board, as far as a neighbourhood reaches (see LifeRule::GetReach)
+	static const int GUARD_CELLS = 2;
+
+	// words of a slot skipped together once their boards settled, and stepped by one job
+	static const int CHUNK_GROUPS = 8;
+
+private:
+	int BoardCount;
+	int Width, Height;
+
+	// words per slot, and words per row of slots (frame included)
+	int GroupCount;
+	ptrdiff_t RowStride;
+
+	// current generation and the one before it, every generation written over the older one
+	std::vector<uint64_t> Buffers[2];
+	int Current;
+	long long Generation;
+
+	// boards that settled, one bit per board like the cells; the bits past the last board are set
+	std::vector<uint64_t> Settled;
+	std::vector<long long> SettledGeneration;
+	std::vector<uint8_t> SettledPeriod;
+	int RunningCount;
+
+	// per group: boards whose last step changed them, and boards whose last step differs from two generations back
+	std::vector<uint64_t> Changed, Cycled;
+
+	const uint64_t* Slot(int buffer, int row, int column) const { return &Buffers[buffer][(size_t)(row + GUARD_CELLS) * RowStride + (size_t)(column + GUARD_CELLS) * GroupCount]; }
+	uint64_t* Slot(int buffer, int row, int column) { return &Buffers[buffer][(size_t)(row + GUARD_CELLS) * RowStride + (size_t)(column + GUARD_CELLS) * GroupCount]; }
+
+	// forget which boards settled
+	void ResetTracking();
+
+	// whether every board of the chunk settled
+	bool IsChunkSettled(int chunk) const;
+};
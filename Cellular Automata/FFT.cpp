@@ -0,0 +1,129 @@
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+// plain complex product, without the inf/nan recovery std::complex may call into
+static inline FFT::Complex Multiply(FFT::Complex a, FFT::Complex b)
+{
+	return FFT::Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+FFT::FFT()
+	: Size(0), PowerSize(0)
+{
+
+}
+
+void FFT::Resize(int size)
+{
+	Size = std::max(size, 1);
+
+	bool power = (Size & (Size - 1)) == 0;
+	PowerSize = 1;
+	while (PowerSize < (power ? Size : 2 * Size - 1))
+		PowerSize *= 2;
+
+	int bits = 0;
+	while ((1 << bits) < PowerSize)
+		bits++;
+
+	BitReverse.resize(PowerSize);
+	for (int i = 0; i < PowerSize; i++)
+	{
+		int reversed = 0;
+		for (int bit = 0; bit < bits; bit++)
+			reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+		BitReverse[i] = reversed;
+	}
+
+	// exp(-2 pi i k / PowerSize), computed in double
+	Twiddles.resize(PowerSize / 2);
+	for (int k = 0; k < PowerSize / 2; k++)
+		Twiddles[k] = Complex((float)std::cos(2.0 * PI * k / PowerSize), (float)-std::sin(2.0 * PI * k / PowerSize));
+
+	Chirp.clear();
+	ChirpSpectrum.clear();
+	if (power)
+		return;
+
+	// k^2 taken modulo 2 * Size keeps the angle exact for large k
+	Chirp.resize(Size);
+	for (int k = 0; k < Size; k++)
+	{
+		double angle = PI * (double)(((long long)k * k) % (2LL * Size)) / Size;
+		Chirp[k] = Complex((float)std::cos(angle), (float)-std::sin(angle));
+	}
+
+	ChirpSpectrum.assign(PowerSize, Complex(0.0f, 0.0f));
+	ChirpSpectrum[0] = std::conj(Chirp[0]);
+	for (int k = 1; k < Size; k++)
+		ChirpSpectrum[k] = ChirpSpectrum[PowerSize - k] = std::conj(Chirp[k]);
+	Radix2(ChirpSpectrum.data(), false);
+}
+
+void FFT::Forward(Complex* data, std::vector<Complex>& scratch) const
+{
+	Transform(data, scratch);
+}
+
+// conj(F(conj(x))) is the inverse transform without the 1 / Size
+void FFT::Inverse(Complex* data, std::vector<Complex>& scratch) const
+{
+	for (int k = 0; k < Size; k++)
+		data[k] = std::conj(data[k]);
+
+	Transform(data, scratch);
+
+	for (int k = 0; k < Size; k++)
+		data[k] = std::conj(data[k]);
+}
+
+void FFT::Transform(Complex* data, std::vector<Complex>& scratch) const
+{
+	if (Chirp.empty())
+	{
+		Radix2(data, false);
+		return;
+	}
+
+	// X[k] = chirp[k] * sum x[j] chirp[j] conj(chirp[k - j])
+	scratch.assign(PowerSize, Complex(0.0f, 0.0f));
+	for (int k = 0; k < Size; k++)
+		scratch[k] = Multiply(data[k], Chirp[k]);
+
+	Radix2(scratch.data(), false);
+	for (int k = 0; k < PowerSize; k++)
+		scratch[k] = Multiply(scratch[k], ChirpSpectrum[k]);
+	Radix2(scratch.data(), true);
+
+	float scale = 1.0f / PowerSize;
+	for (int k = 0; k < Size; k++)
+		data[k] = Multiply(scratch[k], Chirp[k]) * scale;
+}
+
+void FFT::Radix2(Complex* data, bool inverse) const
+{
+	for (int i = 0; i < PowerSize; i++)
+		if (i < BitReverse[i])
+			std::swap(data[i], data[BitReverse[i]]);
+
+	for (int length = 2; length <= PowerSize; length *= 2)
+	{
+		int half = length / 2;
+		int step = PowerSize / length;
+
+		for (int begin = 0; begin < PowerSize; begin += length)
+		{
+			for (int k = 0; k < half; k++)
+			{
+				Complex twiddle = inverse ? std::conj(Twiddles[k * step]) : Twiddles[k * step];
+				Complex odd = Multiply(data[begin + k + half], twiddle);
+				data[begin + k + half] = data[begin + k] - odd;
+				data[begin + k] += odd;
+			}
+		}
+	}
+}
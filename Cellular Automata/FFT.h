@@ -0,0 +1,46 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+/*
+
+	Complex fast Fourier transform of one fixed size. Powers of two run the iterative radix-2 transform with
+	precomputed twiddles, any other size goes through Bluestein's algorithm (a chirp-weighted convolution done
+	with a power-of-two transform), so every size costs O(n log n).
+
+	A transform only reads the plan, several threads can share it as long as each passes its own scratch.
+
+*/
+
+class FFT
+{
+public:
+	typedef std::complex<float> Complex;
+
+	// constructor
+	FFT();
+
+	// plan the transforms of size values
+	void Resize(int size);
+	int GetSize() const { return Size; }
+
+	// in-place transform, unnormalized both ways (Inverse(Forward(x)) = size * x)
+	void Forward(Complex* data, std::vector<Complex>& scratch) const;
+	void Inverse(Complex* data, std::vector<Complex>& scratch) const;
+
+private:
+	int Size;
+
+	// power-of-two transform: Size itself, or the one Bluestein's convolution runs on
+	int PowerSize;
+	std::vector<int> BitReverse;
+	std::vector<Complex> Twiddles;
+
+	// Bluestein: chirp exp(-i pi k^2 / Size) and the spectrum of its conjugate, wrapped around PowerSize
+	std::vector<Complex> Chirp;
+	std::vector<Complex> ChirpSpectrum;
+
+	void Transform(Complex* data, std::vector<Complex>& scratch) const;
+	void Radix2(Complex* data, bool inverse) const;
+};
@@ -0,0 +1,199 @@
+#include "GenerationsGrid.h"
+#include "LifeKernels.h"
+#include "LifeRule.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+GenerationsGrid::GenerationsGrid()
+	: Width(0), Height(0), States(2), PlaneCount(1)
+{
+
+}
+
+void GenerationsGrid::Resize(int width, int height)
+{
+	Width = std::max(width, 0);
+	Height = std::max(height, 0);
+
+	for (int plane = 0; plane < MAX_PLANES; plane++)
+	{
+		if (plane < PlaneCount)
+			Planes[plane].Resize(Width, Height);
+		else
+			Planes[plane].Resize(0, 0);
+	}
+}
+
+void GenerationsGrid::Clear()
+{
+	for (int plane = 0; plane < PlaneCount; plane++)
+		Planes[plane].Clear();
+}
+
+void GenerationsGrid::SetStateCount(int states)
+{
+	states = std::min(std::max(states, 2), GenerationsRule::MAX_STATES);
+	if (states == States)
+		return;
+
+	// bits of the highest state
+	States = states;
+	PlaneCount = 0;
+	while ((1 << PlaneCount) < States)
+		PlaneCount++;
+
+	Resize(Width, Height);
+}
+
+int GenerationsGrid::Get(int row, int column) const
+{
+	int state = 0;
+	for (int plane = 0; plane < PlaneCount; plane++)
+		state |= (int)Planes[plane].Get(row, column) << plane;
+	return state;
+}
+
+void GenerationsGrid::Set(int row, int column, int state)
+{
+	state = std::min(std::max(state, 0), States - 1);
+	for (int plane = 0; plane < PlaneCount; plane++)
+		Planes[plane].Set(row, column, ((state >> plane) & 1) != 0);
+}
+
+void GenerationsGrid::LivingCells(int row, uint64_t* out) const
+{
+	int wordsPerRow = Planes[0].GetWordsPerRow();
+	for (int w = 0; w < wordsPerRow; w++)
+	{
+		uint64_t higher = 0;
+		for (int plane = 1; plane < PlaneCount; plane++)
+			higher |= Planes[plane].Row(row)[w];
+		out[w] = Planes[0].Row(row)[w] & ~higher;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Stepping
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GenerationsGrid::NextGeneration(ThreadPool* pool)
+{
+	int wordsPerRow = Planes[0].GetWordsPerRow();
+	int bandCount = (Height + BAND_ROWS - 1) / BAND_ROWS;
+	if (bandCount == 0)
+		return;
+
+	// living cells of the rows every band reads above and below itself, before any band changes (dead
+	// outside the board)
+	int reach = LifeKernels::GetRule().GetReach();
+	size_t bandWords = (size_t)2 * reach * wordsPerRow;
+	std::vector<uint64_t> edges(bandCount * bandWords, 0);
+
+	for (int band = 0; band < bandCount; band++)
+	{
+		int rowBegin = band * BAND_ROWS;
+		int rowEnd = std::min(rowBegin + BAND_ROWS, Height);
+		uint64_t* around = &edges[band * bandWords];
+
+		for (int i = 0; i < reach; i++)
+		{
+			if (rowBegin - reach + i >= 0)
+				LivingCells(rowBegin - reach + i, around + (size_t)i * wordsPerRow);
+			if (rowEnd + i < Height)
+				LivingCells(rowEnd + i, around + (size_t)(reach + i) * wordsPerRow);
+		}
+	}
+
+	auto stepBand = [&](int band) {
+		int rowBegin = band * BAND_ROWS;
+		int rowEnd = std::min(rowBegin + BAND_ROWS, Height);
+		StepBand(rowBegin, rowEnd, reach, &edges[band * bandWords]);
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || bandCount == 1)
+	{
+		for (int band = 0; band < bandCount; band++)
+			stepBand(band);
+	}
+	else
+	{
+		pool->Run(bandCount, stepBand);
+	}
+}
+
+void GenerationsGrid::StepBand(int rowBegin, int rowEnd, int reach, const uint64_t* around)
+{
+	int rowCount = rowEnd - rowBegin;
+	int wordsPerRow = Planes[0].GetWordsPerRow();
+	ptrdiff_t stride = Planes[0].GetStride();
+
+	// living cells of rows [rowBegin - reach, rowEnd + reach), framed like BitGrid rows so the step kernels can
+	// read them
+	std::vector<uint64_t> living((size_t)(rowCount + 2 * reach) * stride + 2 * BitGrid::ROW_ALIGNMENT, 0);
+	uint64_t* first = living.data() + BitGrid::ROW_ALIGNMENT;
+
+	for (int i = 0; i < reach; i++)
+	{
+		const uint64_t* above = around + (size_t)i * wordsPerRow;
+		const uint64_t* below = around + (size_t)(reach + i) * wordsPerRow;
+		std::copy(above, above + wordsPerRow, first + i * stride);
+		std::copy(below, below + wordsPerRow, first + (reach + rowCount + i) * stride);
+	}
+	for (int i = 0; i < rowCount; i++)
+		LivingCells(rowBegin + i, first + (reach + i) * stride);
+
+	// birth/survival of every cell as if the board was Life-like
+	std::vector<uint64_t> lifeNext((size_t)rowCount * stride + BitGrid::ROW_ALIGNMENT, 0);
+	LifeKernels::StepBuffer(first + reach * stride, lifeNext.data(), stride, wordsPerRow, Planes[0].GetLastWordMask(), rowCount);
+
+	const int dyingState = (States > 2) ? 2 : 0;
+	const int lastState = States - 1;
+
+	for (int i = 0; i < rowCount; i++)
+	{
+		uint64_t* planes[MAX_PLANES];
+		for (int plane = 0; plane < PlaneCount; plane++)
+			planes[plane] = Planes[plane].Row(rowBegin + i);
+
+		const uint64_t* alive = first + (reach + i) * stride;
+		const uint64_t* next = lifeNext.data() + i * stride;
+
+		for (int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t state[MAX_PLANES];
+			uint64_t any = 0;
+			for (int plane = 0; plane < PlaneCount; plane++)
+			{
+				state[plane] = planes[plane][w];
+				any |= state[plane];
+			}
+
+			// only dead cells are born, living cells that do not survive start to fade
+			uint64_t born = next[w] & (alive[w] | ~any);
+			uint64_t dying = alive[w] & ~next[w];
+			uint64_t fading = any & ~alive[w];
+
+			// fading cells move one state up, the last state goes back to dead
+			uint64_t last = fading;
+			for (int plane = 0; plane < PlaneCount; plane++)
+				last &= ((lastState >> plane) & 1) ? state[plane] : ~state[plane];
+			uint64_t moving = fading & ~last;
+
+			uint64_t carry = ~0ULL;
+			for (int plane = 0; plane < PlaneCount; plane++)
+			{
+				uint64_t incremented = state[plane] ^ carry;
+				carry &= state[plane];
+
+				uint64_t bits = moving & incremented;
+				if (plane == 0)
+					bits |= born;
+				if ((dyingState >> plane) & 1)
+					bits |= dying;
+				planes[plane][w] = bits;
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BitGrid.h"
+#include "BitOps.h"
+
+class ThreadPool;
+
+/*
+
+	Board of a Generations rule (see GenerationsRule): the state of every cell is a number in [0, States),
+	stored as bit-planes, plane i holding bit i of every state in a BitGrid. Only the planes the state count
+	needs are allocated, so a cell costs at most 4 bits.
+
+	A step reads the living cells (state 1) out of the planes, counts their neighbours with the Life-like
+	kernel of LifeKernels and updates the planes in place, band by band: only the living cells of the rows the
+	neighbourhood reaches across each band boundary are saved beforehand, so no second board is ever allocated.
+
+*/
+
+class GenerationsGrid
+{
+public:
+	// constructor
+	GenerationsGrid();
+
+	// allocate a dead board of the given size
+	void Resize(int width, int height);
+
+	// kill every cell
+	void Clear();
+
+	// number of states, 2 .. GenerationsRule::MAX_STATES, the board is cleared when it changes
+	void SetStateCount(int states);
+	int GetStateCount() const { return States; }
+
+	// cell access
+	int Get(int row, int column) const;
+	void Set(int row, int column, int state);
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+
+	// advance one generation, with the birth/survival rule of LifeKernels, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column, state) for every cell that is not dead, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const;
+
+	// rows stepped by one job
+	static const int BAND_ROWS = 64;
+
+	static const int MAX_PLANES = 4;
+
+private:
+	int Width, Height;
+	int States;
+	int PlaneCount;
+	BitGrid Planes[MAX_PLANES];
+
+	// living cells (state 1) of words [0, WordsPerRow) of one row
+	void LivingCells(int row, uint64_t* out) const;
+
+	// step rows [rowBegin, rowEnd), around holds the living cells of the reach rows above and the reach rows
+	// below them before the step
+	void StepBand(int rowBegin, int rowEnd, int reach, const uint64_t* around);
+};
+
+template <typename Func>
+void GenerationsGrid::ForEachLiveCell(Func func) const
+{
+	int wordsPerRow = Planes[0].GetWordsPerRow();
+	for (int row = 0; row < Height; row++)
+	{
+		for (int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t any = 0;
+			for (int plane = 0; plane < PlaneCount; plane++)
+				any |= Planes[plane].Row(row)[w];
+
+			while (any)
+			{
+				int column = w * 64 + CountTrailingZeros(any);
+				any &= any - 1;
+				func(row, column, Get(row, column));
+			}
+		}
+	}
+}
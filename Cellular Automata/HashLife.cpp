@@ -0,0 +1,512 @@
+#include "HashLife.h"
+#include "BitGrid.h"
+#include "SparseUniverse.h"
+#include "LifeKernels.h"
+
+#include <algorithm>
+
+// nodes allocated at once
+static const size_t NODE_BLOCK_SIZE = 4096;
+
+// the table window always lies inside [0, 2^TABLE_LEVEL)
+static const int TABLE_LEVEL = 32;
+
+// one tile of the unbounded board, and the square its tile coordinates can address
+static const int TILE_LEVEL = 6;
+static const int64_t TILE_REACH = (1LL << 31) * SparseUniverse::TILE_SIZE;
+
+HashLife::HashLife()
+	: Root(nullptr), Generation(0), NodeCount(0), FreeNodes(nullptr)
+{
+	DeadCell = new HashNode();
+	LiveCell = new HashNode();
+	DeadCell->population = 0;
+	LiveCell->population = 1;
+
+	Buckets.assign(1 << 16, nullptr);
+	Clear();
+}
+
+HashLife::~HashLife()
+{
+	for (HashNode* block : Blocks)
+		delete[] block;
+
+	delete DeadCell;
+	delete LiveCell;
+}
+
+void HashLife::Clear()
+{
+	Root = Empty(3);
+	Generation = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Canonical nodes
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t HashChildren(const HashNode* nw, const HashNode* ne, const HashNode* sw, const HashNode* se)
+{
+	uint64_t h = (uint64_t)(uintptr_t)nw;
+	h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)ne;
+	h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)sw;
+	h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)se;
+	return (size_t)(h ^ (h >> 29));
+}
+
+HashNode* HashLife::AllocateNode()
+{
+	if (FreeNodes == nullptr)
+	{
+		HashNode* block = new HashNode[NODE_BLOCK_SIZE];
+		Blocks.push_back(block);
+
+		for (size_t i = 0; i < NODE_BLOCK_SIZE; i++)
+		{
+			block[i].next = FreeNodes;
+			FreeNodes = &block[i];
+		}
+	}
+
+	HashNode* n = FreeNodes;
+	FreeNodes = n->next;
+	return n;
+}
+
+HashNode* HashLife::Find(HashNode* nw, HashNode* ne, HashNode* sw, HashNode* se)
+{
+	size_t bucket = HashChildren(nw, ne, sw, se) & (Buckets.size() - 1);
+
+	for (HashNode* n = Buckets[bucket]; n != nullptr; n = n->next)
+		if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se)
+			return n;
+
+	HashNode* n = AllocateNode();
+	n->nw = nw;
+	n->ne = ne;
+	n->sw = sw;
+	n->se = se;
+	n->result = nullptr;
+	n->resultStep = -1;
+	n->population = nw->population + ne->population + sw->population + se->population;
+	n->level = nw->level + 1;
+	n->marked = false;
+
+	n->next = Buckets[bucket];
+	Buckets[bucket] = n;
+
+	if (++NodeCount > Buckets.size())
+		Rehash(Buckets.size() * 2);
+
+	return n;
+}
+
+void HashLife::Rehash(size_t bucketCount)
+{
+	std::vector<HashNode*> old(bucketCount, nullptr);
+	old.swap(Buckets);
+
+	for (HashNode* chain : old)
+	{
+		while (chain != nullptr)
+		{
+			HashNode* n = chain;
+			chain = chain->next;
+
+			size_t bucket = HashChildren(n->nw, n->ne, n->sw, n->se) & (Buckets.size() - 1);
+			n->next = Buckets[bucket];
+			Buckets[bucket] = n;
+		}
+	}
+}
+
+HashNode* HashLife::Empty(int level)
+{
+	if (level == 0)
+		return DeadCell;
+
+	while ((int)EmptyNodes.size() <= level)
+		EmptyNodes.push_back(nullptr);
+
+	if (EmptyNodes[level] == nullptr)
+	{
+		HashNode* e = Empty(level - 1);
+		EmptyNodes[level] = Find(e, e, e, e);
+	}
+	return EmptyNodes[level];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Subsquares
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// centered subsquare one level down, no time advance
+HashNode* HashLife::Center(HashNode* n)
+{
+	return Find(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+// same square centered in an empty square one level up
+HashNode* HashLife::Expand(HashNode* n)
+{
+	HashNode* e = Empty(n->level - 1);
+	return Find(Find(e, e, e, n->nw), Find(e, e, n->ne, e), Find(e, n->sw, e, e), Find(n->se, e, e, e));
+}
+
+// 4x4 square -> its 2x2 center after one generation
+HashNode* HashLife::BaseResult(HashNode* n)
+{
+	// bit (4 * row + column) of cells
+	const HashNode* quadrants[4] = { n->nw, n->ne, n->sw, n->se };
+	unsigned int cells = 0;
+	for (int q = 0; q < 4; q++)
+	{
+		int row = (q / 2) * 2, column = (q % 2) * 2;
+		const HashNode* c = quadrants[q];
+		cells |= (unsigned int)c->nw->population << (4 * row + column);
+		cells |= (unsigned int)c->ne->population << (4 * row + column + 1);
+		cells |= (unsigned int)c->sw->population << (4 * (row + 1) + column);
+		cells |= (unsigned int)c->se->population << (4 * (row + 1) + column + 1);
+	}
+
+	HashNode* next[4];
+	for (int i = 0; i < 4; i++)
+	{
+		int row = 1 + i / 2, column = 1 + i % 2;
+
+		int LivingCells = 0;
+		for (int dx = -1; dx <= 1; dx++)
+			for (int dy = -1; dy <= 1; dy++)
+				if (Rule.HasNeighbour(dx, dy))
+					LivingCells += (cells >> (4 * (row + dx) + column + dy)) & 1;
+
+		bool alive = (cells >> (4 * row + column)) & 1;
+		next[i] = Rule.Next(alive, LivingCells) ? LiveCell : DeadCell;
+	}
+
+	return Find(next[0], next[1], next[2], next[3]);
+}
+
+// centered subsquare one level down, advanced 2^step generations (step <= level - 2)
+HashNode* HashLife::Result(HashNode* n, int step)
+{
+	if (n->population == 0)
+		return Empty(n->level - 1);
+
+	if (n->result != nullptr && n->resultStep == step)
+		return n->result;
+
+	HashNode* r;
+	if (n->level == 2)
+	{
+		r = BaseResult(n);
+	}
+	else
+	{
+		// the 9 overlapping subsquares one level down
+		HashNode* n00 = n->nw;
+		HashNode* n01 = Find(n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw);
+		HashNode* n02 = n->ne;
+		HashNode* n10 = Find(n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne);
+		HashNode* n11 = Center(n);
+		HashNode* n12 = Find(n->ne->sw, n->ne->se, n->se->nw, n->se->ne);
+		HashNode* n20 = n->sw;
+		HashNode* n21 = Find(n->sw->ne, n->se->nw, n->sw->se, n->se->sw);
+		HashNode* n22 = n->se;
+
+		// full speed: both halves advance 2^(level-3), otherwise only the second half advances 2^step
+		bool fullSpeed = (step == n->level - 2);
+		int halfStep = fullSpeed ? step - 1 : step;
+
+		HashNode* r00 = fullSpeed ? Result(n00, halfStep) : Center(n00);
+		HashNode* r01 = fullSpeed ? Result(n01, halfStep) : Center(n01);
+		HashNode* r02 = fullSpeed ? Result(n02, halfStep) : Center(n02);
+		HashNode* r10 = fullSpeed ? Result(n10, halfStep) : Center(n10);
+		HashNode* r11 = fullSpeed ? Result(n11, halfStep) : Center(n11);
+		HashNode* r12 = fullSpeed ? Result(n12, halfStep) : Center(n12);
+		HashNode* r20 = fullSpeed ? Result(n20, halfStep) : Center(n20);
+		HashNode* r21 = fullSpeed ? Result(n21, halfStep) : Center(n21);
+		HashNode* r22 = fullSpeed ? Result(n22, halfStep) : Center(n22);
+
+		r = Find(Result(Find(r00, r01, r10, r11), halfStep),
+				 Result(Find(r01, r02, r11, r12), halfStep),
+				 Result(Find(r10, r11, r20, r21), halfStep),
+				 Result(Find(r11, r12, r21, r22), halfStep));
+	}
+
+	n->result = r;
+	n->resultStep = step;
+	return r;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Stepping
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HashLife::Step(int log2Generations)
+{
+	if (LifeKernels::GetRule() != Rule)
+	{
+		Rule = LifeKernels::GetRule();
+		ForgetResults();
+	}
+
+	if (NodeCount > MAX_NODES)
+		CollectGarbage();
+
+	// grow until the pattern sits in the central quarter of a square big enough for the jump:
+	// it then cannot reach the border of the (central half) result within 2^log2Generations generations
+	while (true)
+	{
+		bool bigEnough = Root->level >= std::max(log2Generations + 3, 4);
+		if (bigEnough)
+		{
+			uint64_t inner = Root->nw->se->se->population + Root->ne->sw->sw->population +
+							 Root->sw->ne->ne->population + Root->se->nw->nw->population;
+			if (inner == Root->population)
+				break;
+		}
+		Root = Expand(Root);
+	}
+
+	Root = Result(Root, log2Generations);
+	Generation += 1ULL << log2Generations;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Table conversion
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HashLife::Load(const BitGrid& grid)
+{
+	// the table is the south-east quadrant of the root
+	int level = 3;
+	while ((1LL << (level - 1)) < std::max(grid.GetWidth(), grid.GetHeight()))
+		level++;
+
+	HashNode* e = Empty(level - 1);
+	Root = Find(e, e, e, Build(grid, level - 1, 0, 0));
+}
+
+HashNode* HashLife::Build(const BitGrid& grid, int level, int64_t row, int64_t column)
+{
+	if (row >= grid.GetHeight() || column >= grid.GetWidth())
+		return Empty(level);
+
+	if (level == 0)
+		return grid.Get((int)row, (int)column) ? LiveCell : DeadCell;
+
+	int64_t half = 1LL << (level - 1);
+	return Find(Build(grid, level - 1, row, column), Build(grid, level - 1, row, column + half),
+				Build(grid, level - 1, row + half, column), Build(grid, level - 1, row + half, column + half));
+}
+
+void HashLife::Store(BitGrid& grid) const
+{
+	grid.Clear();
+
+	// descend to the square [0, 2^TABLE_LEVEL) so the coordinates below fit in 64 bits
+	const HashNode* n = Root->se;
+	while (n->level > TABLE_LEVEL)
+		n = n->nw;
+
+	Write(n, grid, 0, 0);
+}
+
+void HashLife::Write(const HashNode* n, BitGrid& grid, int64_t row, int64_t column) const
+{
+	if (n->population == 0 || row >= grid.GetHeight() || column >= grid.GetWidth())
+		return;
+
+	if (n->level == 0)
+	{
+		grid.Set((int)row, (int)column, true);
+		return;
+	}
+
+	int64_t half = 1LL << (n->level - 1);
+	Write(n->nw, grid, row, column);
+	Write(n->ne, grid, row, column + half);
+	Write(n->sw, grid, row + half, column);
+	Write(n->se, grid, row + half, column + half);
+}
+
+void HashLife::Load(const SparseUniverse& universe)
+{
+	Root = Empty(3);
+
+	universe.ForEachTile([this](int64_t tileRow, int64_t tileColumn, const uint64_t* rows) {
+		int64_t row = tileRow * SparseUniverse::TILE_SIZE;
+		int64_t column = tileColumn * SparseUniverse::TILE_SIZE;
+
+		// grow until the root covers the tile
+		while (true)
+		{
+			int64_t half = 1LL << (Root->level - 1);
+			if (-half <= std::min(row, column) && std::max(row, column) + SparseUniverse::TILE_SIZE <= half)
+				break;
+			Root = Expand(Root);
+		}
+
+		int64_t half = 1LL << (Root->level - 1);
+		Root = Insert(Root, -half, -half, row, column, BuildTile(rows, TILE_LEVEL, 0, 0));
+	});
+}
+
+// copy of n (whose corner is at row, column) with the square of the same level as square at target replaced
+HashNode* HashLife::Insert(HashNode* n, int64_t row, int64_t column, int64_t targetRow, int64_t targetColumn, HashNode* square)
+{
+	if (n->level == square->level)
+		return square;
+
+	int64_t half = 1LL << (n->level - 1);
+	bool south = targetRow >= row + half;
+	bool east = targetColumn >= column + half;
+	int64_t childRow = south ? row + half : row;
+	int64_t childColumn = east ? column + half : column;
+
+	HashNode* nw = n->nw;
+	HashNode* ne = n->ne;
+	HashNode* sw = n->sw;
+	HashNode* se = n->se;
+	HashNode*& child = south ? (east ? se : sw) : (east ? ne : nw);
+	child = Insert(child, childRow, childColumn, targetRow, targetColumn, square);
+
+	return Find(nw, ne, sw, se);
+}
+
+HashNode* HashLife::BuildTile(const uint64_t* rows, int level, int row, int column)
+{
+	if (level == 0)
+		return ((rows[row] >> column) & 1) ? LiveCell : DeadCell;
+
+	int half = 1 << (level - 1);
+	return Find(BuildTile(rows, level - 1, row, column), BuildTile(rows, level - 1, row, column + half),
+				BuildTile(rows, level - 1, row + half, column), BuildTile(rows, level - 1, row + half, column + half));
+}
+
+void HashLife::Store(SparseUniverse& universe) const
+{
+	universe.Clear();
+
+	int64_t half = 1LL << (Root->level - 1);
+	WriteTiles(Root, universe, -half, -half);
+}
+
+void HashLife::WriteTiles(const HashNode* n, SparseUniverse& universe, int64_t row, int64_t column) const
+{
+	if (n->population == 0)
+		return;
+
+	// squares the board cannot address are dropped
+	int64_t size = 1LL << n->level;
+	if (row >= TILE_REACH || column >= TILE_REACH || row + size <= -TILE_REACH || column + size <= -TILE_REACH)
+		return;
+
+	if (n->level == TILE_LEVEL)
+	{
+		uint64_t rows[SparseUniverse::TILE_SIZE] = {};
+		WriteTile(n, rows, 0, 0);
+		universe.SetTile(FloorDiv64(row), FloorDiv64(column), rows);
+		return;
+	}
+
+	int64_t half = size / 2;
+	WriteTiles(n->nw, universe, row, column);
+	WriteTiles(n->ne, universe, row, column + half);
+	WriteTiles(n->sw, universe, row + half, column);
+	WriteTiles(n->se, universe, row + half, column + half);
+}
+
+void HashLife::WriteTile(const HashNode* n, uint64_t* rows, int row, int column) const
+{
+	if (n->population == 0)
+		return;
+
+	if (n->level == 0)
+	{
+		rows[row] |= 1ULL << column;
+		return;
+	}
+
+	int half = 1 << (n->level - 1);
+	WriteTile(n->nw, rows, row, column);
+	WriteTile(n->ne, rows, row, column + half);
+	WriteTile(n->sw, rows, row + half, column);
+	WriteTile(n->se, rows, row + half, column + half);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Garbage collection
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HashLife::Mark(HashNode* n)
+{
+	if (n->level == 0 || n->marked)
+		return;
+
+	n->marked = true;
+	Mark(n->nw);
+	Mark(n->ne);
+	Mark(n->sw);
+	Mark(n->se);
+}
+
+void HashLife::CollectGarbage()
+{
+	Mark(Root);
+
+	// keep the marked nodes, forget results that point to nodes being freed
+	size_t kept = 0;
+	for (HashNode*& chain : Buckets)
+	{
+		HashNode* n = chain;
+		chain = nullptr;
+
+		while (n != nullptr)
+		{
+			HashNode* next = n->next;
+			if (n->marked)
+			{
+				n->next = chain;
+				chain = n;
+				kept++;
+			}
+			else
+			{
+				n->next = FreeNodes;
+				FreeNodes = n;
+			}
+			n = next;
+		}
+	}
+
+	for (HashNode* chain : Buckets)
+	{
+		for (HashNode* n = chain; n != nullptr; n = n->next)
+		{
+			if (n->result != nullptr && n->result->level > 0 && !n->result->marked)
+				n->result = nullptr;
+		}
+	}
+
+	for (HashNode* chain : Buckets)
+		for (HashNode* n = chain; n != nullptr; n = n->next)
+			n->marked = false;
+
+	NodeCount = kept;
+	EmptyNodes.clear();
+}
+
+void HashLife::ForgetResults()
+{
+	for (HashNode* chain : Buckets)
+	{
+		for (HashNode* n = chain; n != nullptr; n = n->next)
+		{
+			n->result = nullptr;
+			n->resultStep = -1;
+		}
+	}
+}
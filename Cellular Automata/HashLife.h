@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LifeRule.h"
+
+class BitGrid;
+class SparseUniverse;
+
+/*
+
+	HashLife: the plane is a quadtree of canonical nodes (every distinct square exists only once, found
+	through a hash table on its four children), and every node of level L memoizes its RESULT, the
+	centered square of level L-1 advanced by 2^k generations. Periodic and repetitive patterns then reuse
+	almost every result, so a jump of 2^k generations costs about as much as a few hundred generations.
+
+	Cell (row, column) uses the same coordinates as the table; the plane is unbounded, so nothing is
+	clipped at the table border while stepping.
+
+*/
+
+struct HashNode
+{
+	HashNode* nw;
+	HashNode* ne;
+	HashNode* sw;
+	HashNode* se;
+
+	// memoized center after 2^resultStep generations
+	HashNode* result;
+	int resultStep;
+
+	// hash table chain
+	HashNode* next;
+
+	uint64_t population;
+	int level;
+	bool marked;
+};
+
+class HashLife
+{
+public:
+	// constructor
+	HashLife();
+	~HashLife();
+
+	// empty plane
+	void Clear();
+
+	// copy the whole table into the plane / the window of the plane covered by the table back into it
+	void Load(const BitGrid& grid);
+	void Store(BitGrid& grid) const;
+
+	// same for the unbounded board, only the part reachable by its tile coordinates is stored
+	void Load(const SparseUniverse& universe);
+	void Store(SparseUniverse& universe) const;
+
+	// advance 2^log2Generations generations under the rule of LifeKernels, whose neighbourhood must fit in the
+	// 3x3 square (LifeRule::GetReach() == 1)
+	void Step(int log2Generations);
+
+	uint64_t GetGeneration() const { return Generation; }
+	uint64_t GetPopulation() const { return Root->population; }
+	size_t GetNodeCount() const { return NodeCount; }
+
+	// nodes kept before the memoized results are thrown away
+	static const size_t MAX_NODES = 4 * 1024 * 1024;
+
+private:
+	// root covers [-2^(level-1), 2^(level-1)) in both directions
+	HashNode* Root;
+	uint64_t Generation;
+
+	// rule the memoized results were computed with
+	LifeRule Rule;
+
+	// canonical nodes
+	std::vector<HashNode*> Buckets;
+	size_t NodeCount;
+	std::vector<HashNode*> Blocks;
+	HashNode* FreeNodes;
+	HashNode* DeadCell;
+	HashNode* LiveCell;
+	std::vector<HashNode*> EmptyNodes;
+
+	// node creation
+	HashNode* AllocateNode();
+	HashNode* Find(HashNode* nw, HashNode* ne, HashNode* sw, HashNode* se);
+	HashNode* Empty(int level);
+	void Rehash(size_t bucketCount);
+
+	// subsquares
+	HashNode* Center(HashNode* n);
+	HashNode* Expand(HashNode* n);
+	HashNode* Result(HashNode* n, int step);
+	HashNode* BaseResult(HashNode* n);
+
+	// conversion from/to the table
+	HashNode* Build(const BitGrid& grid, int level, int64_t row, int64_t column);
+	void Write(const HashNode* n, BitGrid& grid, int64_t row, int64_t column) const;
+	HashNode* BuildTile(const uint64_t* rows, int level, int row, int column);
+	void WriteTile(const HashNode* n, uint64_t* rows, int row, int column) const;
+	void WriteTiles(const HashNode* n, SparseUniverse& universe, int64_t row, int64_t column) const;
+	HashNode* Insert(HashNode* n, int64_t row, int64_t column, int64_t targetRow, int64_t targetColumn, HashNode* square);
+
+	// throw away every node that is not part of the current pattern
+	void CollectGarbage();
+	void Mark(HashNode* n);
+
+	// throw away every memoized result
+	void ForgetResults();
+};
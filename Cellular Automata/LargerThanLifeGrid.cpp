@@ -0,0 +1,121 @@
+#include "LargerThanLifeGrid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+LargerThanLifeGrid::LargerThanLifeGrid()
+	: Current(0)
+{
+
+}
+
+void LargerThanLifeGrid::Resize(int width, int height)
+{
+	Boards[0].Resize(width, height);
+	Boards[1].Resize(width, height);
+}
+
+void LargerThanLifeGrid::Clear()
+{
+	Boards[0].Clear();
+	Boards[1].Clear();
+}
+
+void LargerThanLifeGrid::NextGeneration(ThreadPool* pool)
+{
+	int height = Boards[Current].GetHeight();
+	int bandCount = (height + BAND_ROWS - 1) / BAND_ROWS;
+
+	// bands only write their own rows of the other board
+	auto stepBand = [&](int band) {
+		StepBand(band * BAND_ROWS, std::min((band + 1) * BAND_ROWS, height));
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || bandCount <= 1)
+	{
+		for (int band = 0; band < bandCount; band++)
+			stepBand(band);
+	}
+	else
+	{
+		pool->Run(bandCount, stepBand);
+	}
+
+	// the bands wrote the rows of the board themselves
+	Boards[Current ^ 1].MeasureTiles(Boards[Current]);
+	Current ^= 1;
+}
+
+void LargerThanLifeGrid::StepBand(int rowBegin, int rowEnd)
+{
+	const BitGrid& src = Boards[Current];
+	BitGrid& dst = Boards[Current ^ 1];
+
+	int width = src.GetWidth();
+	int height = src.GetHeight();
+	int wordsPerRow = src.GetWordsPerRow();
+	int radius = Rule.Radius;
+
+	// living cells of every column in rows [row - radius, row + radius], with radius dead columns on both sides
+	std::vector<int> columnSums((size_t)width + 2 * radius, 0);
+	int* sums = columnSums.data() + radius;
+
+	auto addRow = [&](int row, int delta) {
+		if (row < 0 || row >= height)
+			return;
+
+		const uint64_t* words = src.Row(row);
+		for (int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t bits = words[w];
+			while (bits)
+			{
+				sums[w * 64 + CountTrailingZeros(bits)] += delta;
+				bits &= bits - 1;
+			}
+		}
+	};
+
+	for (int row = rowBegin - radius; row <= rowBegin + radius; row++)
+		addRow(row, 1);
+
+	for (int row = rowBegin; row < rowEnd; row++)
+	{
+		// slide the rows down
+		if (row > rowBegin)
+		{
+			addRow(row + radius, 1);
+			addRow(row - radius - 1, -1);
+		}
+
+		// window of columns [column - radius, column + radius], missing its rightmost column
+		int window = 0;
+		for (int column = -radius; column < radius; column++)
+			window += sums[column];
+
+		const uint64_t* cells = src.Row(row);
+		uint64_t* out = dst.Row(row);
+
+		for (int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t next = 0;
+			int bitEnd = std::min(64, width - w * 64);
+
+			for (int bit = 0; bit < bitEnd; bit++)
+			{
+				int column = w * 64 + bit;
+				window += sums[column + radius];
+
+				bool alive = ((cells[w] >> bit) & 1) != 0;
+				int count = window - ((alive && !Rule.CountSelf) ? 1 : 0);
+				if (Rule.Next(alive, count))
+					next |= 1ULL << bit;
+
+				window -= sums[column - radius];
+			}
+
+			out[w] = next;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "BitGrid.h"
+#include "LifeRule.h"
+
+class ThreadPool;
+
+/*
+
+	Board of a Larger than Life rule (see LargerThanLifeRule), bit-packed like the Life board.
+
+	Counting a (2R+1)x(2R+1) square per cell would cost O(R^2). Instead every band of rows keeps, for each
+	column, the number of living cells in the 2R+1 rows around the current row (one row added and one
+	removed per step down), and slides a 2R+1 wide window along those column sums (one column added and
+	one removed per step right), so every cell costs O(1) whatever the radius.
+
+*/
+
+class LargerThanLifeGrid
+{
+public:
+	// constructor
+	LargerThanLifeGrid();
+
+	// allocate a dead board of the given size
+	void Resize(int width, int height);
+
+	// kill every cell
+	void Clear();
+
+	void SetRule(const LargerThanLifeRule& rule) { Rule = rule; }
+	const LargerThanLifeRule& GetRule() const { return Rule; }
+
+	// cell access
+	bool Get(int row, int column) const { return Boards[Current].Get(row, column); }
+	void Set(int row, int column, bool alive) { Boards[Current].Set(row, column, alive); }
+
+	// advance one generation, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column) for every living cell, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const { Boards[Current].ForEachLiveCell(func); }
+
+	// rows stepped by one job
+	static const int BAND_ROWS = 64;
+
+private:
+	LargerThanLifeRule Rule;
+
+	// current board and the one the next generation is written into
+	BitGrid Boards[2];
+	int Current;
+
+	void StepBand(int rowBegin, int rowEnd);
+};
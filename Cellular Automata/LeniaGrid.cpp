@@ -0,0 +1,223 @@
+#include "LeniaGrid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+LeniaGrid::LeniaGrid()
+	: Width(0), Height(0), SpectrumWidth(0), Random(1)
+{
+
+}
+
+void LeniaGrid::Resize(int width, int height)
+{
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	SpectrumWidth = Width / 2 + 1;
+
+	Cells.assign((size_t)Width * Height, 0.0f);
+	Spectrum.assign((size_t)SpectrumWidth * Height, Complex(0.0f, 0.0f));
+
+	RowTransform.Resize(Width);
+	ColumnTransform.Resize(Height);
+
+	BuildKernel();
+}
+
+void LeniaGrid::Clear()
+{
+	std::fill(Cells.begin(), Cells.end(), 0.0f);
+}
+
+void LeniaGrid::SetRule(const LeniaRule& rule)
+{
+	Rule = rule;
+	if (!Cells.empty())
+		BuildKernel();
+}
+
+void LeniaGrid::Brush(int row, int column, bool add)
+{
+	int radius = std::max(Rule.Radius / 2, 1);
+	std::uniform_real_distribution<float> value(0.0f, 1.0f);
+
+	for (int dy = -radius; dy <= radius; dy++)
+	{
+		for (int dx = -radius; dx <= radius; dx++)
+		{
+			if (dx * dx + dy * dy > radius * radius)
+				continue;
+
+			int y = ((row + dy) % Height + Height) % Height;
+			int x = ((column + dx) % Width + Width) % Width;
+			Set(y, x, add ? value(Random) : 0.0f);
+		}
+	}
+}
+
+void LeniaGrid::BuildKernel()
+{
+	// ring of radius Rule.Radius around cell (0, 0), wrapped around the board
+	std::vector<float> kernel((size_t)Width * Height, 0.0f);
+	double total = 0.0;
+
+	int radius = Rule.Radius;
+	for (int dy = -radius; dy <= radius; dy++)
+	{
+		for (int dx = -radius; dx <= radius; dx++)
+		{
+			double r = std::sqrt((double)(dx * dx + dy * dy)) / radius;
+			if (r <= 0.0 || r >= 1.0)
+				continue;
+
+			double weight = std::exp(4.0 - 1.0 / (r * (1.0 - r)));
+			int y = ((dy % Height) + Height) % Height;
+			int x = ((dx % Width) + Width) % Width;
+			kernel[(size_t)y * Width + x] += (float)weight;
+			total += weight;
+		}
+	}
+
+	// sum 1, and the 1 / (Width * Height) of the inverse transforms
+	float scale = (float)(1.0 / (total * Width * Height));
+	for (float& weight : kernel)
+		weight *= scale;
+
+	ForwardRows(kernel.data(), 0, (Height + 1) / 2);
+	TransformColumns(0, SpectrumWidth, false);
+	KernelSpectrum = Spectrum;
+}
+
+template <typename Step>
+void LeniaGrid::RunBands(ThreadPool* pool, int count, Step step)
+{
+	int bandCount = (count + BAND_ROWS - 1) / BAND_ROWS;
+
+	auto stepBand = [&](int band) {
+		step(band * BAND_ROWS, std::min((band + 1) * BAND_ROWS, count));
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || bandCount <= 1)
+	{
+		for (int band = 0; band < bandCount; band++)
+			stepBand(band);
+	}
+	else
+	{
+		pool->Run(bandCount, stepBand);
+	}
+}
+
+void LeniaGrid::NextGeneration(ThreadPool* pool)
+{
+	int pairs = (Height + 1) / 2;
+
+	RunBands(pool, pairs, [&](int begin, int end) { ForwardRows(Cells.data(), begin, end); });
+	RunBands(pool, SpectrumWidth, [&](int begin, int end) { TransformColumns(begin, end, true); });
+	RunBands(pool, pairs, [&](int begin, int end) { InverseRows(begin, end); });
+}
+
+// row pair p holds rows 2p and 2p + 1 (zero past the last row)
+void LeniaGrid::ForwardRows(const float* image, int begin, int end)
+{
+	std::vector<Complex> row(Width), scratch;
+
+	for (int pair = begin; pair < end; pair++)
+	{
+		const float* even = image + (size_t)(2 * pair) * Width;
+		const float* odd = (2 * pair + 1 < Height) ? even + Width : nullptr;
+
+		for (int x = 0; x < Width; x++)
+			row[x] = Complex(even[x], odd ? odd[x] : 0.0f);
+
+		RowTransform.Forward(row.data(), scratch);
+
+		// spectra of the real rows a and b out of z = a + ib: A[k] = (z[k] + conj z[-k]) / 2, B[k] = (z[k] - conj z[-k]) / 2i
+		Complex* evenSpectrum = &Spectrum[(size_t)(2 * pair) * SpectrumWidth];
+		Complex* oddSpectrum = odd ? evenSpectrum + SpectrumWidth : nullptr;
+
+		for (int k = 0; k < SpectrumWidth; k++)
+		{
+			Complex z = row[k];
+			Complex mirror = std::conj(row[(Width - k) % Width]);
+
+			evenSpectrum[k] = (z + mirror) * 0.5f;
+			if (oddSpectrum)
+			{
+				Complex difference = z - mirror;
+				oddSpectrum[k] = Complex(difference.imag() * 0.5f, -difference.real() * 0.5f);
+			}
+		}
+	}
+}
+
+void LeniaGrid::TransformColumns(int begin, int end, bool convolve)
+{
+	std::vector<Complex> column(Height), scratch;
+
+	for (int k = begin; k < end; k++)
+	{
+		for (int y = 0; y < Height; y++)
+			column[y] = Spectrum[(size_t)y * SpectrumWidth + k];
+
+		ColumnTransform.Forward(column.data(), scratch);
+
+		if (convolve)
+		{
+			for (int y = 0; y < Height; y++)
+			{
+				Complex a = column[y];
+				Complex b = KernelSpectrum[(size_t)y * SpectrumWidth + k];
+				column[y] = Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+			}
+
+			ColumnTransform.Inverse(column.data(), scratch);
+		}
+
+		for (int y = 0; y < Height; y++)
+			Spectrum[(size_t)y * SpectrumWidth + k] = column[y];
+	}
+}
+
+void LeniaGrid::InverseRows(int begin, int end)
+{
+	std::vector<Complex> row(Width), scratch;
+	float step = 1.0f / Rule.Steps;
+
+	for (int pair = begin; pair < end; pair++)
+	{
+		bool hasOdd = 2 * pair + 1 < Height;
+		const Complex* evenSpectrum = &Spectrum[(size_t)(2 * pair) * SpectrumWidth];
+		const Complex* oddSpectrum = hasOdd ? evenSpectrum + SpectrumWidth : nullptr;
+
+		// z = a + ib from the half spectra, the other half being their conjugates
+		for (int k = 0; k < Width; k++)
+		{
+			bool mirrored = k >= SpectrumWidth;
+			int index = mirrored ? Width - k : k;
+
+			Complex a = evenSpectrum[index];
+			Complex b = hasOdd ? oddSpectrum[index] : Complex(0.0f, 0.0f);
+			if (mirrored)
+			{
+				a = std::conj(a);
+				b = std::conj(b);
+			}
+
+			row[k] = Complex(a.real() - b.imag(), a.imag() + b.real());
+		}
+
+		RowTransform.Inverse(row.data(), scratch);
+
+		for (int half = 0; half < (hasOdd ? 2 : 1); half++)
+		{
+			float* cells = &Cells[(size_t)(2 * pair + half) * Width];
+			for (int x = 0; x < Width; x++)
+			{
+				float potential = half ? row[x].imag() : row[x].real();
+				cells[x] = std::min(std::max(cells[x] + step * Rule.Growth(potential), 0.0f), 1.0f);
+			}
+		}
+	}
+}
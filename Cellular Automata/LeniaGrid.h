@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FFT.h"
+#include "LifeRule.h"
+
+#include <random>
+#include <vector>
+
+class ThreadPool;
+
+/*
+
+	Board of a Lenia rule (see LeniaRule): one float per cell, edges wrapped around (a torus).
+
+	The ring kernel reaches Radius cells in every direction, so a direct convolution would cost O(R^2) per
+	cell. The board is convolved in frequency space instead, in O(log(WH)) per cell whatever the radius:
+
+	- rows are transformed two at a time, packed into the real and imaginary parts of one complex transform
+	  and separated afterwards, keeping only the Width / 2 + 1 columns a real signal needs
+	- every one of those columns is transformed, multiplied by the kernel spectrum and transformed back
+	- row pairs are rebuilt from their half spectra, transformed back, and the growth is applied
+
+	The kernel spectrum is computed once per rule and board size, already divided by the Width * Height the
+	two unnormalized transforms multiply by.
+
+*/
+
+class LeniaGrid
+{
+public:
+	// constructor
+	LeniaGrid();
+
+	// allocate an empty board of the given size
+	void Resize(int width, int height);
+
+	// empty every cell
+	void Clear();
+
+	void SetRule(const LeniaRule& rule);
+	const LeniaRule& GetRule() const { return Rule; }
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+
+	// cell access, values in [0, 1]
+	float Get(int row, int column) const { return Cells[(size_t)row * Width + column]; }
+	void Set(int row, int column, float value) { Cells[(size_t)row * Width + column] = value; }
+
+	// fill a disc of radius Radius / 2 around (row, column) with random values, or empty it
+	void Brush(int row, int column, bool add);
+
+	// advance one generation, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column, value) for every cell above VISIBLE_VALUE, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const;
+
+	// cells below this value are drawn as empty
+	static constexpr float VISIBLE_VALUE = 0.02f;
+
+	// rows or columns transformed by one job
+	static const int BAND_ROWS = 32;
+
+private:
+	typedef FFT::Complex Complex;
+
+	LeniaRule Rule;
+
+	int Width, Height;
+	std::vector<float> Cells;
+
+	// Height rows of Width / 2 + 1 frequencies
+	int SpectrumWidth;
+	std::vector<Complex> Spectrum;
+	std::vector<Complex> KernelSpectrum;
+
+	FFT RowTransform, ColumnTransform;
+
+	std::mt19937 Random;
+
+	void BuildKernel();
+
+	// steps of the convolution over rows or columns [begin, end)
+	void ForwardRows(const float* image, int begin, int end);
+	void TransformColumns(int begin, int end, bool convolve);
+	void InverseRows(int begin, int end);
+
+	// run step(begin, end) over [0, count) in bands of BAND_ROWS
+	template <typename Step>
+	void RunBands(ThreadPool* pool, int count, Step step);
+};
+
+template <typename Func>
+void LeniaGrid::ForEachLiveCell(Func func) const
+{
+	for (int row = 0; row < Height; row++)
+	{
+		const float* values = &Cells[(size_t)row * Width];
+		for (int column = 0; column < Width; column++)
+			if (values[column] > VISIBLE_VALUE)
+				func(row, column, values[column]);
+	}
+}
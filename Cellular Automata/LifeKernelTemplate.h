@@ -0,0 +1,677 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "LifeRule.h"
+
+// the neighbour and count chains below are template recursions 25 calls deep, which compilers stop inlining
+// on their own long before the end
+#ifdef _MSC_VER
+#define LIFE_KERNEL_INLINE __forceinline
+#else
+#define LIFE_KERNEL_INLINE inline __attribute__((always_inline))
+#endif
+
+/*
+
+	Bit-sliced Life-like row kernel shared by the scalar and SIMD step kernels.
+
+	Lanes is a traits struct describing one vector of WORDS consecutive 64-bit words (Load/Store are
+	unaligned, the bit operations and shifts work on each 64-bit lane separately). Each SIMD kernel
+	includes this header in its own translation unit, compiled for its instruction set, so the
+	instantiation must stay internal to that unit: do not call into other inline code from here.
+
+	Relies on the BitGrid layout: stride is a multiple of 8 words with at least one dead spare word per
+	row, and the LifeRule::GetReach() rows above the first and below the last row passed in are readable.
+	Words [wordBegin, wordEnd) of every row are stepped, rounded out to whole vectors.
+
+	The rule is a type: FixedRule carries its masks as template arguments, so the count tests fold into a
+	handful of bit operations with no branch at all, while MaskRule reads them at run time (once per
+	vector, not per cell) for every rule without a specialized kernel.
+
+	So is the neighbourhood: Moore has its own adder tree, the von Neumann and hex neighbourhoods are
+	FixedNeighbourhood masks, unrolled at compile time into one shifted load and one bit-sliced increment
+	per neighbour, and any other mask is a MaskNeighbourhood, tested cell by cell once per vector.
+
+	ElementaryKernel steps a single row of an elementary rule (see ElementaryGrid) on the same lanes.
+
+	EnsembleKernel steps boards bit-sliced across words (see EnsembleGrid): a word holds one cell of 64 boards,
+	so the neighbours of a cell are whole other words, loaded with no shift at all, and a vector of WORDS words
+	steps a cell of 64 * WORDS boards through the same adder tree and count tests as above.
+
+	MargolusKernel steps the 2x2 blocks of a pair of rows under a Margolus rule (see MargolusRule): every cell
+	is picked out of 16 table words by a tree of selects on the four cells of its block, like the elementary
+	rules, the words holding the entries of the west cells at the even bits and of the east cells at the odd
+	ones, so a tree steps a whole row of 32 blocks per word.
+
+*/
+
+namespace
+{
+	// rule known at compile time
+	template <unsigned int BIRTH, unsigned int SURVIVAL>
+	struct FixedRule
+	{
+		unsigned int GetBirth() const { return BIRTH; }
+		unsigned int GetSurvival() const { return SURVIVAL; }
+	};
+
+	// any other rule
+	struct MaskRule
+	{
+		unsigned int Birth, Survival;
+
+		unsigned int GetBirth() const { return Birth; }
+		unsigned int GetSurvival() const { return Survival; }
+	};
+
+	typedef FixedRule<RULE_MASK_B3, RULE_MASK_S23> LifeRuleType;
+	typedef FixedRule<RULE_MASK_B36, RULE_MASK_S23> HighLifeRuleType;
+
+	// bits needed to count up to count
+	constexpr int CountBits(int count)
+	{
+		return (count == 0) ? 0 : 1 + CountBits(count / 2);
+	}
+
+	constexpr int MaskSize(unsigned int mask)
+	{
+		return (mask == 0) ? 0 : (int)(mask & 1) + MaskSize(mask >> 1);
+	}
+
+	// neighbourhood known at compile time (see LifeRule for the mask layout)
+	template <unsigned int MASK>
+	struct FixedNeighbourhood
+	{
+		static const int COUNT_BITS = CountBits(MaskSize(MASK));
+
+		unsigned int GetMask() const { return MASK; }
+	};
+
+	// any other neighbourhood
+	struct MaskNeighbourhood
+	{
+		static const int COUNT_BITS = CountBits(MAX_NEIGHBOURS);
+
+		unsigned int Mask;
+
+		unsigned int GetMask() const { return Mask; }
+	};
+
+	typedef FixedNeighbourhood<NEIGHBOURHOOD_MOORE> MooreType;
+
+	// call func with the rule type matching rule.Kernel and the neighbourhood type matching rule.Neighbourhood
+	template <typename Func>
+	inline void DispatchRule(const LifeRule& rule, Func func)
+	{
+		switch (rule.Neighbourhood)
+		{
+		case NEIGHBOURHOOD_MOORE:			break;
+		case NEIGHBOURHOOD_VON_NEUMANN:		func(MaskRule{ rule.Birth, rule.Survival }, FixedNeighbourhood<NEIGHBOURHOOD_VON_NEUMANN>());		return;
+		case NEIGHBOURHOOD_HEX:				func(MaskRule{ rule.Birth, rule.Survival }, FixedNeighbourhood<NEIGHBOURHOOD_HEX>());				return;
+		default:							func(MaskRule{ rule.Birth, rule.Survival }, MaskNeighbourhood{ rule.Neighbourhood });				return;
+		}
+
+		switch (rule.Kernel)
+		{
+		case RULE_LIFE:				func(LifeRuleType(), MooreType());											break;
+		case RULE_HIGHLIFE:			func(HighLifeRuleType(), MooreType());										break;
+		case RULE_DAY_AND_NIGHT:	func(FixedRule<RULE_MASK_B3678, RULE_MASK_S34678>(), MooreType());			break;
+		case RULE_SEEDS:			func(FixedRule<RULE_MASK_B2, RULE_MASK_S>(), MooreType());					break;
+		case RULE_REPLICATOR:		func(FixedRule<RULE_MASK_B1357, RULE_MASK_S1357>(), MooreType());			break;
+		default:					func(MaskRule{ rule.Birth, rule.Survival }, MooreType());					break;
+		}
+	}
+
+	template <typename Lanes>
+	struct LifeKernel
+	{
+		typedef typename Lanes::Vec Vec;
+
+		static inline void FullAdd(Vec a, Vec b, Vec c, Vec& sum, Vec& carry)
+		{
+			Vec t = Lanes::Xor(a, b);
+			sum = Lanes::Xor(t, c);
+			carry = Lanes::Or(Lanes::And(a, b), Lanes::And(t, c));
+		}
+
+		// bit i of the result is the cell at column i - 1
+		static inline Vec West(const uint64_t* row, int w)
+		{
+			return Lanes::Or(Lanes::template ShiftLeft<1>(Lanes::Load(row + w)), Lanes::template ShiftRight<63>(Lanes::Load(row + w - 1)));
+		}
+
+		// bit i of the result is the cell at column i + 1
+		static inline Vec East(const uint64_t* row, int w)
+		{
+			return Lanes::Or(Lanes::template ShiftRight<1>(Lanes::Load(row + w)), Lanes::template ShiftLeft<63>(Lanes::Load(row + w + 1)));
+		}
+
+		// bit i of the result is the cell at column i + COLUMN, |COLUMN| < 64
+		template <int COLUMN>
+		static inline Vec Shifted(const uint64_t* row, int w)
+		{
+			const int left = (COLUMN < 0) ? -COLUMN : 1;
+			const int right = (COLUMN > 0) ? COLUMN : 1;
+
+			if (COLUMN < 0)
+				return Lanes::Or(Lanes::template ShiftLeft<left>(Lanes::Load(row + w)), Lanes::template ShiftRight<64 - left>(Lanes::Load(row + w - 1)));
+			if (COLUMN > 0)
+				return Lanes::Or(Lanes::template ShiftRight<right>(Lanes::Load(row + w)), Lanes::template ShiftLeft<64 - right>(Lanes::Load(row + w + 1)));
+			return Lanes::Load(row + w);
+		}
+
+		// next state of the cells of words [w, w + WORDS) of the row mid, with the Moore adder tree
+		template <typename Rule>
+		static inline Vec Step(const Rule& rule, const MooreType&, const uint64_t* mid, ptrdiff_t stride, int w)
+		{
+			const uint64_t* up = mid - stride;
+			const uint64_t* down = mid + stride;
+			return Next(rule, West(up, w), Lanes::Load(up + w), East(up, w),
+						West(mid, w), Lanes::Load(mid + w), East(mid, w),
+						West(down, w), Lanes::Load(down + w), East(down, w));
+		}
+
+		// same for any other neighbourhood: count = sum of counts[bit] << bit, one bit-sliced increment per neighbour
+		template <typename Rule, typename Neighbourhood>
+		static inline Vec Step(const Rule& rule, const Neighbourhood& neighbourhood, const uint64_t* mid, ptrdiff_t stride, int w)
+		{
+			const int BITS = Neighbourhood::COUNT_BITS;
+			Vec alive = Lanes::Load(mid + w);
+
+			Vec counts[BITS];
+			for (int bit = 0; bit < BITS; bit++)
+				counts[bit] = Lanes::Xor(alive, alive);
+
+			int added = 0;
+			AddNeighbours(neighbourhood, counts, added, mid, stride, w, std::integral_constant<int, 0>());
+
+			Vec next = Lanes::Xor(alive, alive);
+			AddCountTerms<BITS>(rule, next, alive, counts, std::integral_constant<int, 0>());
+			return next;
+		}
+
+		// cell CELL of the 5x5 square, then the ones after it
+		template <typename Neighbourhood, int CELL>
+		static LIFE_KERNEL_INLINE void AddNeighbours(const Neighbourhood& neighbourhood, Vec* counts, int& added, const uint64_t* mid, ptrdiff_t stride, int w, std::integral_constant<int, CELL>)
+		{
+			if ((neighbourhood.GetMask() >> CELL) & 1)
+			{
+				// counts += 1 where the neighbour lives, carrying through the bits the count can have by now
+				Vec carry = Shifted<CELL % 5 - 2>(mid + (CELL / 5 - 2) * stride, w);
+				added++;
+				for (int bit = 0; bit < Neighbourhood::COUNT_BITS && (added >> bit) != 0; bit++)
+				{
+					Vec sum = Lanes::Xor(counts[bit], carry);
+					carry = Lanes::And(counts[bit], carry);
+					counts[bit] = sum;
+				}
+			}
+
+			AddNeighbours(neighbourhood, counts, added, mid, stride, w, std::integral_constant<int, CELL + 1>());
+		}
+
+		template <typename Neighbourhood>
+		static inline void AddNeighbours(const Neighbourhood&, Vec*, int&, const uint64_t*, ptrdiff_t, int, std::integral_constant<int, 25>)
+		{
+
+		}
+
+		// cells with exactly N neighbours, then N + 1 .. MAX_NEIGHBOURS (counts are BITS bits wide)
+		template <int BITS, typename Rule, int N>
+		static LIFE_KERNEL_INLINE void AddCountTerms(const Rule& rule, Vec& next, Vec alive, const Vec* counts, std::integral_constant<int, N>)
+		{
+			bool birth = ((rule.GetBirth() >> N) & 1) != 0;
+			bool survival = ((rule.GetSurvival() >> N) & 1) != 0;
+			if ((birth || survival) && (N >> BITS) == 0)
+			{
+				// N == 0 only survives (B0 is rejected): the living cells with every bit absent
+				Vec present = alive;
+				Vec absent = Lanes::Xor(alive, alive);
+				bool first = (N != 0);
+
+				for (int bit = 0; bit < BITS; bit++)
+				{
+					if ((N >> bit) & 1)
+					{
+						present = first ? counts[bit] : Lanes::And(present, counts[bit]);
+						first = false;
+					}
+					else
+					{
+						absent = Lanes::Or(absent, counts[bit]);
+					}
+				}
+
+				Vec exact = Lanes::AndNot(absent, present);
+				if (N == 0 || (survival && !birth))
+					next = Lanes::Or(next, (N == 0) ? exact : Lanes::And(alive, exact));
+				else if (birth && !survival)
+					next = Lanes::Or(next, Lanes::AndNot(alive, exact));
+				else
+					next = Lanes::Or(next, exact);
+			}
+
+			AddCountTerms<BITS>(rule, next, alive, counts, std::integral_constant<int, N + 1>());
+		}
+
+		template <int BITS, typename Rule>
+		static inline void AddCountTerms(const Rule&, Vec&, Vec, const Vec*, std::integral_constant<int, MAX_NEIGHBOURS + 1>)
+		{
+
+		}
+
+		// next state of the centre cells given the 3x3 neighbourhood, already shifted into place
+		template <typename Rule>
+		static inline Vec Next(const Rule& rule, Vec upWest, Vec up, Vec upEast, Vec west, Vec mid, Vec east, Vec downWest, Vec down, Vec downEast)
+		{
+			// column sums of the row above and below, and the two horizontal neighbours
+			Vec upOnes, upTwos, downOnes, downTwos;
+			FullAdd(upWest, up, upEast, upOnes, upTwos);
+			FullAdd(downWest, down, downEast, downOnes, downTwos);
+
+			Vec midOnes = Lanes::Xor(west, east);
+			Vec midTwos = Lanes::And(west, east);
+
+			// add the three partial sums
+			Vec ones, carry;
+			FullAdd(upOnes, downOnes, midOnes, ones, carry);
+
+			Vec twosPartial, foursPartial;
+			FullAdd(upTwos, downTwos, midTwos, twosPartial, foursPartial);
+
+			// count = ones + 2 * twos + 4 * fours + 8 * eights
+			Vec fourCarry = Lanes::And(twosPartial, carry);
+			Vec twos = Lanes::Xor(twosPartial, carry);
+			Vec fours = Lanes::Xor(foursPartial, fourCarry);
+			Vec eights = Lanes::And(foursPartial, fourCarry);
+
+			return Apply(rule, mid, ones, twos, fours, eights);
+		}
+
+		// B3/S23: count == 3, or count == 2 and alive (count 10 and 11 cannot happen)
+		static inline Vec Apply(const LifeRuleType&, Vec alive, Vec ones, Vec twos, Vec fours, Vec)
+		{
+			return Lanes::AndNot(fours, Lanes::And(twos, Lanes::Or(ones, alive)));
+		}
+
+		// B36/S23: Life, and dead cells with count == 6
+		static inline Vec Apply(const HighLifeRuleType&, Vec alive, Vec ones, Vec twos, Vec fours, Vec)
+		{
+			Vec life = Lanes::AndNot(fours, Lanes::And(twos, Lanes::Or(ones, alive)));
+			return Lanes::Or(life, Lanes::AndNot(Lanes::Or(ones, alive), Lanes::And(twos, fours)));
+		}
+
+		// one term per neighbour count in the rule
+		template <typename Rule>
+		static inline Vec Apply(const Rule& rule, Vec alive, Vec ones, Vec twos, Vec fours, Vec eights)
+		{
+			Vec next = Lanes::Xor(alive, alive);
+			AddTerm<0>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<1>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<2>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<3>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<4>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<5>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<6>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<7>(rule, next, alive, ones, twos, fours, eights);
+			AddTerm<8>(rule, next, alive, ones, twos, fours, eights);
+			return next;
+		}
+
+		// cells with exactly N neighbours: every set bit of N present, every clear bit absent
+		template <int N, typename Rule>
+		static inline void AddTerm(const Rule& rule, Vec& next, Vec alive, Vec ones, Vec twos, Vec fours, Vec eights)
+		{
+			bool birth = ((rule.GetBirth() >> N) & 1) != 0;
+			bool survival = ((rule.GetSurvival() >> N) & 1) != 0;
+			if (!birth && !survival)
+				return;
+
+			// N == 0 only survives (B0 is rejected): the living cells with every bit absent
+			Vec present = alive;
+			Vec absent = Lanes::Xor(alive, alive);
+			bool first = (N != 0);
+
+			// eights is only ever set alone, so any other set bit already rules it out
+			const Vec counts[4] = { ones, twos, fours, eights };
+			int bits = (N != 0 && N != 8) ? 3 : 4;
+			for (int bit = 0; bit < bits; bit++)
+			{
+				if ((N >> bit) & 1)
+				{
+					present = first ? counts[bit] : Lanes::And(present, counts[bit]);
+					first = false;
+				}
+				else
+				{
+					absent = Lanes::Or(absent, counts[bit]);
+				}
+			}
+
+			Vec exact = Lanes::AndNot(absent, present);
+			if (N == 0 || (survival && !birth))
+				next = Lanes::Or(next, (N == 0) ? exact : Lanes::And(alive, exact));
+			else if (birth && !survival)
+				next = Lanes::Or(next, Lanes::AndNot(alive, exact));
+			else
+				next = Lanes::Or(next, exact);
+		}
+
+		static void StepRows(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+		{
+			DispatchRule(rule, [&](const auto& ruleType, const auto& neighbourhood) {
+				StepRowsWith(ruleType, neighbourhood, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+			});
+		}
+
+		template <typename Rule, typename Neighbourhood>
+		static void StepRowsWith(const Rule& rule, const Neighbourhood& neighbourhood, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+		{
+			if (wordBegin >= wordEnd)
+				return;
+
+			// whole aligned vectors: the extra words around the range get their correct next state too, and
+			// the tail may run into the row padding which is cleaned up below
+			int vectorBegin = wordBegin / Lanes::WORDS * Lanes::WORDS;
+			int vectorEnd = (wordEnd + Lanes::WORDS - 1) / Lanes::WORDS * Lanes::WORDS;
+
+			for (int row = 0; row < rowCount; row++)
+			{
+				const uint64_t* mid = src + row * stride;
+				uint64_t* out = dst + row * stride;
+
+				for (int w = vectorBegin; w < vectorEnd; w += Lanes::WORDS)
+					Lanes::Store(out + w, Step(rule, neighbourhood, mid, stride, w));
+
+				// columns past the right edge are outside the board
+				if (vectorEnd >= wordsPerRow)
+				{
+					out[wordsPerRow - 1] &= lastWordMask;
+					for (int w = wordsPerRow; w < vectorEnd; w++)
+						out[w] = 0;
+				}
+			}
+		}
+	};
+
+	template <typename Lanes>
+	struct ElementaryKernel
+	{
+		typedef typename Lanes::Vec Vec;
+
+		static inline Vec Select(Vec mask, Vec ones, Vec zeros)
+		{
+			return Lanes::Or(Lanes::And(mask, ones), Lanes::AndNot(mask, zeros));
+		}
+
+		// table holds truth table entry 4 * left + 2 * center + right as an all-zero/all-one word, words
+		// wordBegin - 1 and wordEnd of src are read
+		static void StepWords(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd)
+		{
+			uint64_t repeated[8][Lanes::WORDS];
+			for (int entry = 0; entry < 8; entry++)
+				for (int lane = 0; lane < Lanes::WORDS; lane++)
+					repeated[entry][lane] = table[entry];
+
+			Vec t[8];
+			for (int entry = 0; entry < 8; entry++)
+				t[entry] = Lanes::Load(repeated[entry]);
+
+			int w = wordBegin;
+			for (; w + Lanes::WORDS <= wordEnd; w += Lanes::WORDS)
+			{
+				Vec center = Lanes::Load(src + w);
+				Vec left = Lanes::Or(Lanes::template ShiftLeft<1>(center), Lanes::template ShiftRight<63>(Lanes::Load(src + w - 1)));
+				Vec right = Lanes::Or(Lanes::template ShiftRight<1>(center), Lanes::template ShiftLeft<63>(Lanes::Load(src + w + 1)));
+
+				Vec deadLeft = Select(center, Select(right, t[3], t[2]), Select(right, t[1], t[0]));
+				Vec liveLeft = Select(center, Select(right, t[7], t[6]), Select(right, t[5], t[4]));
+				Lanes::Store(dst + w, Select(left, liveLeft, deadLeft));
+			}
+
+			// words left over past the last whole vector
+			for (; w < wordEnd; w++)
+			{
+				uint64_t center = src[w];
+				uint64_t left = (center << 1) | (src[w - 1] >> 63);
+				uint64_t right = (center >> 1) | (src[w + 1] << 63);
+
+				uint64_t deadLeft = (center & ((right & table[3]) | (~right & table[2]))) | (~center & ((right & table[1]) | (~right & table[0])));
+				uint64_t liveLeft = (center & ((right & table[7]) | (~right & table[6]))) | (~center & ((right & table[5]) | (~right & table[4])));
+				dst[w] = (left & liveLeft) | (~left & deadLeft);
+			}
+		}
+	};
+
+	struct ScalarLanes
+	{
+		typedef uint64_t Vec;
+		static const int WORDS = 1;
+
+		static inline Vec Load(const uint64_t* p) { return *p; }
+		static inline void Store(uint64_t* p, Vec v) { *p = v; }
+		static inline Vec And(Vec a, Vec b) { return a & b; }
+		static inline Vec Or(Vec a, Vec b) { return a | b; }
+		static inline Vec Xor(Vec a, Vec b) { return a ^ b; }
+		static inline Vec AndNot(Vec a, Vec b) { return ~a & b; }
+		template <int N> static inline Vec ShiftLeft(Vec a) { return a << N; }
+		template <int N> static inline Vec ShiftRight(Vec a) { return a >> N; }
+	};
+
+	template <typename Lanes>
+	struct EnsembleKernel
+	{
+		typedef typename Lanes::Vec Vec;
+		typedef LifeKernel<Lanes> Cells;
+
+		// next state of the cell at slot of groups [g, g + WORDS), with the Moore adder tree
+		template <typename Rule>
+		static inline Vec Step(const Rule& rule, const MooreType&, const uint64_t* slot, ptrdiff_t rowStride, int slotWords)
+		{
+			const uint64_t* up = slot - rowStride;
+			const uint64_t* down = slot + rowStride;
+			return Cells::Next(rule, Lanes::Load(up - slotWords), Lanes::Load(up), Lanes::Load(up + slotWords),
+							   Lanes::Load(slot - slotWords), Lanes::Load(slot), Lanes::Load(slot + slotWords),
+							   Lanes::Load(down - slotWords), Lanes::Load(down), Lanes::Load(down + slotWords));
+		}
+
+		// same for any other neighbourhood, one bit-sliced increment per neighbour
+		template <typename Rule, typename Neighbourhood>
+		static inline Vec Step(const Rule& rule, const Neighbourhood& neighbourhood, const uint64_t* slot, ptrdiff_t rowStride, int slotWords)
+		{
+			const int BITS = Neighbourhood::COUNT_BITS;
+			Vec alive = Lanes::Load(slot);
+
+			Vec counts[BITS];
+			for (int bit = 0; bit < BITS; bit++)
+				counts[bit] = Lanes::Xor(alive, alive);
+
+			int added = 0;
+			AddNeighbours(neighbourhood, counts, added, slot, rowStride, slotWords, std::integral_constant<int, 0>());
+
+			Vec next = Lanes::Xor(alive, alive);
+			Cells::template AddCountTerms<BITS>(rule, next, alive, counts, std::integral_constant<int, 0>());
+			return next;
+		}
+
+		// cell CELL of the 5x5 square, then the ones after it
+		template <typename Neighbourhood, int CELL>
+		static LIFE_KERNEL_INLINE void AddNeighbours(const Neighbourhood& neighbourhood, Vec* counts, int& added, const uint64_t* slot, ptrdiff_t rowStride, int slotWords, std::integral_constant<int, CELL>)
+		{
+			if ((neighbourhood.GetMask() >> CELL) & 1)
+			{
+				Vec carry = Lanes::Load(slot + (CELL / 5 - 2) * rowStride + (CELL % 5 - 2) * slotWords);
+				added++;
+				for (int bit = 0; bit < Neighbourhood::COUNT_BITS && (added >> bit) != 0; bit++)
+				{
+					Vec sum = Lanes::Xor(counts[bit], carry);
+					carry = Lanes::And(counts[bit], carry);
+					counts[bit] = sum;
+				}
+			}
+
+			AddNeighbours(neighbourhood, counts, added, slot, rowStride, slotWords, std::integral_constant<int, CELL + 1>());
+		}
+
+		template <typename Neighbourhood>
+		static inline void AddNeighbours(const Neighbourhood&, Vec*, int&, const uint64_t*, ptrdiff_t, int, std::integral_constant<int, 25>)
+		{
+
+		}
+
+		// src and dst point at the slot of cell (0, 0), the slot of cell (row, column) is row * rowStride +
+		// column * slotWords words further and the slots of the cells around the boards are readable. Groups
+		// [groupBegin, groupEnd) of every cell are stepped, changed[g] gets the boards of group g whose next
+		// generation differs from src and cycled[g] the ones whose next generation differs from what dst held
+		static void StepGroups(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+		{
+			DispatchRule(rule, [&](const auto& ruleType, const auto& neighbourhood) {
+				int g = groupBegin;
+				for (; g + Lanes::WORDS <= groupEnd; g += Lanes::WORDS)
+					StepLanes(ruleType, neighbourhood, src + g, dst + g, rowStride, slotWords, width, height, changed + g, cycled + g);
+
+				// groups left over past the last whole vector
+				for (; g < groupEnd; g++)
+					EnsembleKernel<ScalarLanes>::StepLanes(ruleType, neighbourhood, src + g, dst + g, rowStride, slotWords, width, height, changed + g, cycled + g);
+			});
+		}
+
+		// every cell of the WORDS groups src and dst point at
+		template <typename Rule, typename Neighbourhood>
+		static void StepLanes(const Rule& rule, const Neighbourhood& neighbourhood, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, uint64_t* changed, uint64_t* cycled)
+		{
+			Vec changedLanes = Lanes::Xor(Lanes::Load(src), Lanes::Load(src));
+			Vec cycledLanes = changedLanes;
+
+			for (int row = 0; row < height; row++)
+			{
+				for (int column = 0; column < width; column++)
+				{
+					const uint64_t* slot = src + row * rowStride + column * slotWords;
+					uint64_t* out = dst + row * rowStride + column * slotWords;
+
+					Vec next = Step(rule, neighbourhood, slot, rowStride, slotWords);
+					changedLanes = Lanes::Or(changedLanes, Lanes::Xor(next, Lanes::Load(slot)));
+					cycledLanes = Lanes::Or(cycledLanes, Lanes::Xor(next, Lanes::Load(out)));
+					Lanes::Store(out, next);
+				}
+			}
+
+			Lanes::Store(changed, changedLanes);
+			Lanes::Store(cycled, cycledLanes);
+		}
+	};
+
+	// bits of the even columns of a word
+	const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+	template <typename Lanes>
+	struct MargolusKernel
+	{
+		typedef typename Lanes::Vec Vec;
+
+		static inline Vec Select(Vec mask, Vec ones, Vec zeros)
+		{
+			return Lanes::Or(Lanes::And(mask, ones), Lanes::AndNot(mask, zeros));
+		}
+
+		// next state of the cells of a row of blocks, t[entry] for entry = self + 2 beside + 4 other + 8 across
+		static inline Vec Cell(const Vec* t, Vec self, Vec beside, Vec other, Vec across)
+		{
+			Vec low = Select(other, Select(beside, Select(self, t[7], t[6]), Select(self, t[5], t[4])), Select(beside, Select(self, t[3], t[2]), Select(self, t[1], t[0])));
+			Vec high = Select(other, Select(beside, Select(self, t[15], t[14]), Select(self, t[13], t[12])), Select(beside, Select(self, t[11], t[10]), Select(self, t[9], t[8])));
+			return Select(across, high, low);
+		}
+
+		// the blocks whose north-west cell is at an even bit of top. Every cell is stepped where it is, from itself,
+		// the cell beside it in the block (the two bits of every pair swapped), the one in the other row and the one
+		// across the block: only the leaves of the tree differ between the west (even) and east (odd) cells
+		static inline void Blocks(const Vec* t, Vec even, Vec top, Vec bottom, Vec& nextTop, Vec& nextBottom)
+		{
+			Vec besideTop = Lanes::Or(Lanes::And(even, Lanes::template ShiftRight<1>(top)), Lanes::AndNot(even, Lanes::template ShiftLeft<1>(top)));
+			Vec besideBottom = Lanes::Or(Lanes::And(even, Lanes::template ShiftRight<1>(bottom)), Lanes::AndNot(even, Lanes::template ShiftLeft<1>(bottom)));
+
+			nextTop = Cell(t, top, besideTop, bottom, besideBottom);
+			nextBottom = Cell(t + 16, bottom, besideBottom, top, besideTop);
+		}
+
+		// words [0, count) of a pair of rows, blocks at even columns
+		static void StepWords(const uint64_t* table, const Vec* t, Vec even, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, int count)
+		{
+			int w = 0;
+			for (; w + Lanes::WORDS <= count; w += Lanes::WORDS)
+			{
+				Vec nextTop, nextBottom;
+				Blocks(t, even, Lanes::Load(top + w), Lanes::Load(bottom + w), nextTop, nextBottom);
+				Lanes::Store(outTop + w, nextTop);
+				Lanes::Store(outBottom + w, nextBottom);
+			}
+
+			// words left over past the last whole vector
+			for (; w < count; w++)
+				MargolusKernel<ScalarLanes>::Blocks(table, EVEN_BITS, top[w], bottom[w], outTop[w], outBottom[w]);
+		}
+
+		// dst[i] = columns 64 i + COLUMN .. 64 i + COLUMN + 63 of src, COLUMN = 1 or -1, for i in [0, count)
+		template <int COLUMN>
+		static void ShiftWords(const uint64_t* src, uint64_t* dst, int count)
+		{
+			const int left = (COLUMN < 0) ? 1 : 63;
+			const int right = (COLUMN < 0) ? 63 : 1;
+			const int other = (COLUMN < 0) ? -1 : 1;
+
+			int w = 0;
+			for (; w + Lanes::WORDS <= count; w += Lanes::WORDS)
+			{
+				Vec words = Lanes::Load(src + w), beside = Lanes::Load(src + w + other);
+				Lanes::Store(dst + w, (COLUMN < 0) ? Lanes::Or(Lanes::template ShiftLeft<left>(words), Lanes::template ShiftRight<right>(beside))
+												   : Lanes::Or(Lanes::template ShiftRight<right>(words), Lanes::template ShiftLeft<left>(beside)));
+			}
+
+			for (; w < count; w++)
+				dst[w] = (COLUMN < 0) ? (src[w] << left) | (src[w - 1] >> right) : (src[w] >> right) | (src[w + 1] << left);
+		}
+
+		// word 16 * row + entry of table is the next state of the cells of the top (row 0) or bottom (row 1) row of
+		// the blocks around entry (see Cell), west cells at the even bits and east cells at the odd ones. The blocks
+		// of the rows top and bottom starting at even columns, or odd ones, are stepped into outTop and outBottom
+		// over words [wordBegin, wordEnd). Odd blocks are stepped one column to the right in scratch (2 * (wordEnd -
+		// wordBegin + 1) words), words wordBegin - 1 and wordEnd of the rows are read
+		static void StepRows(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+		{
+			if (wordBegin >= wordEnd)
+				return;
+
+			uint64_t repeated[33][Lanes::WORDS];
+			for (int entry = 0; entry < 33; entry++)
+				for (int lane = 0; lane < Lanes::WORDS; lane++)
+					repeated[entry][lane] = (entry < 32) ? table[entry] : EVEN_BITS;
+
+			Vec t[32];
+			for (int entry = 0; entry < 32; entry++)
+				t[entry] = Lanes::Load(repeated[entry]);
+			Vec even = Lanes::Load(repeated[32]);
+
+			if (!odd)
+			{
+				StepWords(table, t, even, top + wordBegin, bottom + wordBegin, outTop + wordBegin, outBottom + wordBegin, wordEnd - wordBegin);
+				return;
+			}
+
+			// bit i of scratch word j is column 64 (wordBegin - 1 + j) + i + 1, where the odd blocks start at even bits
+			int count = wordEnd - wordBegin + 1;
+			uint64_t* shiftedTop = scratch;
+			uint64_t* shiftedBottom = scratch + count;
+			ShiftWords<1>(top + wordBegin - 1, shiftedTop, count);
+			ShiftWords<1>(bottom + wordBegin - 1, shiftedBottom, count);
+
+			StepWords(table, t, even, shiftedTop, shiftedBottom, shiftedTop, shiftedBottom, count);
+
+			ShiftWords<-1>(shiftedTop + 1, outTop + wordBegin, count - 1);
+			ShiftWords<-1>(shiftedBottom + 1, outBottom + wordBegin, count - 1);
+		}
+	};
+}
@@ -0,0 +1,366 @@
+#include "LifeKernels.h"
+#include "LifeKernelTemplate.h"
+#include "BitGrid.h"
+#include "DoubleBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#ifdef LIFE_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Instantiate static variables
+EStepKernel LifeKernels::Selected = KERNEL_SCALAR;
+StepKernel LifeKernels::Kernel = StepRowsScalar;
+ElementaryKernelFunc LifeKernels::ElementaryKernel = StepElementaryScalar;
+EnsembleKernelFunc LifeKernels::EnsembleKernel = StepEnsembleScalar;
+MargolusKernelFunc LifeKernels::MargolusKernel = StepMargolusScalar;
+LifeRule LifeKernels::Rule;
+
+void StepRowsScalar(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	LifeKernel<ScalarLanes>::StepRows(rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+}
+
+void StepElementaryScalar(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd)
+{
+	ElementaryKernel<ScalarLanes>::StepWords(table, src, dst, wordBegin, wordEnd);
+}
+
+void StepEnsembleScalar(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+{
+	EnsembleKernel<ScalarLanes>::StepGroups(rule, src, dst, rowStride, slotWords, width, height, groupBegin, groupEnd, changed, cycled);
+}
+
+void StepMargolusScalar(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+{
+	MargolusKernel<ScalarLanes>::StepRows(table, top, bottom, outTop, outBottom, scratch, wordBegin, wordEnd, odd);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														CPUID
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LIFE_KERNELS_X86
+
+static void CpuId(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuidex(info, (int)leaf, (int)subleaf);
+	for (int i = 0; i < 4; i++)
+		regs[i] = (unsigned int)info[i];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// register state the OS saves on context switch (XCR0)
+static uint64_t EnabledStateMask()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+#endif
+
+bool LifeKernels::IsSupported(EStepKernel kernel)
+{
+	if (kernel == KERNEL_SCALAR || kernel == KERNEL_LOOKUP)
+		return true;
+
+#ifdef LIFE_KERNELS_X86
+	unsigned int regs[4];
+	CpuId(0, 0, regs);
+	unsigned int maxLeaf = regs[0];
+
+	CpuId(1, 0, regs);
+	bool sse2 = (regs[3] >> 26) & 1;
+	bool osxsave = (regs[2] >> 27) & 1;
+	bool avx = (regs[2] >> 28) & 1;
+
+	if (kernel == KERNEL_SSE2)
+		return sse2;
+
+	if (!osxsave || !avx || maxLeaf < 7)
+		return false;
+
+	uint64_t state = EnabledStateMask();
+	bool ymmState = (state & 0x06) == 0x06;			// SSE + AVX registers
+	bool zmmState = (state & 0xE6) == 0xE6;			// + opmask and upper ZMM registers
+
+	CpuId(7, 0, regs);
+	bool avx2 = (regs[1] >> 5) & 1;
+	bool avx512f = (regs[1] >> 16) & 1;
+
+	if (kernel == KERNEL_AVX2)
+		return avx2 && ymmState;
+	if (kernel == KERNEL_AVX512)
+		return avx512f && zmmState;
+#endif
+
+	return false;
+}
+
+EStepKernel LifeKernels::DetectBest()
+{
+	for (int kernel = KERNEL_AVX512; kernel > KERNEL_SCALAR; kernel--)
+		if (IsSupported((EStepKernel)kernel))
+			return (EStepKernel)kernel;
+	return KERNEL_SCALAR;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Selection
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LifeKernels::Init(const std::string& name)
+{
+	EStepKernel kernel = DetectBest();
+
+	if (!name.empty())
+	{
+		EStepKernel forced;
+		if (!FindByName(name, forced))
+			std::cout << "Unknown step kernel \"" << name << "\", using " << GetName(kernel) << std::endl;
+		else if (!IsSupported(forced))
+			std::cout << "Step kernel " << GetName(forced) << " is not supported by this CPU, using " << GetName(kernel) << std::endl;
+		else
+			kernel = forced;
+	}
+
+	Select(kernel);
+	std::cout << "Step kernel: " << GetName(Selected) << std::endl;
+}
+
+bool LifeKernels::Select(EStepKernel kernel)
+{
+	if (!IsSupported(kernel))
+		return false;
+
+	if (kernel == KERNEL_LOOKUP)
+		BuildLookupTable(Rule);
+
+	switch (kernel)
+	{
+	case KERNEL_LOOKUP:	Kernel = StepRowsLookup;	ElementaryKernel = StepElementaryScalar;	EnsembleKernel = StepEnsembleScalar;	MargolusKernel = StepMargolusScalar;	break;
+#ifdef LIFE_KERNELS_X86
+	case KERNEL_SSE2:	Kernel = StepRowsSSE2;		ElementaryKernel = StepElementarySSE2;		EnsembleKernel = StepEnsembleSSE2;		MargolusKernel = StepMargolusSSE2;		break;
+	case KERNEL_AVX2:	Kernel = StepRowsAVX2;		ElementaryKernel = StepElementaryAVX2;		EnsembleKernel = StepEnsembleAVX2;		MargolusKernel = StepMargolusAVX2;		break;
+	case KERNEL_AVX512:	Kernel = StepRowsAVX512;	ElementaryKernel = StepElementaryAVX512;	EnsembleKernel = StepEnsembleAVX512;	MargolusKernel = StepMargolusAVX512;	break;
+#endif
+	default:			Kernel = StepRowsScalar;	ElementaryKernel = StepElementaryScalar;	EnsembleKernel = StepEnsembleScalar;	MargolusKernel = StepMargolusScalar;	break;
+	}
+
+	Selected = kernel;
+	return true;
+}
+
+EStepKernel LifeKernels::GetSelected()
+{
+	return Selected;
+}
+
+static const char* KernelNames[KERNEL_COUNT] = { "scalar", "sse2", "avx2", "avx512", "lookup" };
+
+const char* LifeKernels::GetName(EStepKernel kernel)
+{
+	return KernelNames[kernel];
+}
+
+bool LifeKernels::FindByName(const std::string& name, EStepKernel& kernel)
+{
+	for (int i = 0; i < KERNEL_COUNT; i++)
+	{
+		if (name == KernelNames[i])
+		{
+			kernel = (EStepKernel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void LifeKernels::SetRule(const LifeRule& rule)
+{
+	Rule = rule;
+	if (Selected == KERNEL_LOOKUP)
+		BuildLookupTable(Rule);
+}
+
+const LifeRule& LifeKernels::GetRule()
+{
+	return Rule;
+}
+
+void LifeKernels::StepRows(const BitGrid& src, BitGrid& dst, int rowBegin, int rowEnd)
+{
+	StepRegion(src, dst, rowBegin, rowEnd, 0, src.GetWordsPerRow());
+}
+
+void LifeKernels::StepRegion(const BitGrid& src, BitGrid& dst, int rowBegin, int rowEnd, int wordBegin, int wordEnd)
+{
+	if (rowBegin >= rowEnd)
+		return;
+
+	Kernel(Rule, src.Row(rowBegin), dst.Row(rowBegin), src.GetStride(), src.GetWordsPerRow(), src.GetLastWordMask(), rowEnd - rowBegin, wordBegin, wordEnd);
+}
+
+void LifeKernels::StepBuffer(const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount)
+{
+	StepBuffer(src, dst, stride, wordsPerRow, lastWordMask, rowCount, 0, wordsPerRow);
+}
+
+void LifeKernels::StepBuffer(const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	if (rowCount > 0)
+		Kernel(Rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Benchmark
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LifeKernels::Benchmark(int width, int height, int generations, int timeBlock)
+{
+	BitGrid board, next;
+	board.Resize(width, height);
+	next.Resize(width, height);
+
+	std::mt19937 random(1);
+	for (int row = 0; row < height; row++)
+		for (int column = 0; column < width; column++)
+			board.Set(row, column, random() % 3 == 0);
+
+	EStepKernel previous = Selected;
+	std::cout << "Benchmark: " << width << "x" << height << ", " << generations << " generations of " << Rule.ToString() << std::endl;
+
+	for (int kernel = 0; kernel < KERNEL_COUNT; kernel++)
+	{
+		if (!Select((EStepKernel)kernel))
+			continue;
+
+		// the whole board every generation, no tile skipping
+		BitGrid a = board, b = next;
+		BitGrid* src = &a;
+		BitGrid* dst = &b;
+
+		auto start = std::chrono::steady_clock::now();
+		for (int generation = 0; generation < generations; generation++)
+		{
+			StepRows(*src, *dst, 0, height);
+			std::swap(src, dst);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "  " << GetName((EStepKernel)kernel) << ": " << seconds * 1000.0 / generations << " ms/generation, "
+				  << (double)width * height * generations / seconds / 1e9 << " Gcells/s" << std::endl;
+
+		if (timeBlock <= 1)
+			continue;
+
+		// the same generations in temporal blocks, whole passes only
+		int passes = std::max(generations / timeBlock, 1);
+		a = board;
+		src = &a;
+		dst = &b;
+
+		start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			src->NextGenerations(*dst, timeBlock);
+			std::swap(src, dst);
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "  " << GetName((EStepKernel)kernel) << ", " << timeBlock << " generations per pass: " << seconds * 1000.0 / ((double)passes * timeBlock) << " ms/generation, "
+				  << (double)width * height * passes * timeBlock / seconds / 1e9 << " Gcells/s" << std::endl;
+	}
+
+	Select(previous);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Self-test
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// step boards of separate blobs through a DoubleBuffer (quiet and asleep tiles left to the back board) and through
+// boards written whole, returns the first generation they differ at or -1
+static int CheckReplay()
+{
+	const int width = 1024, height = 256, generations = 300;
+	const int tileRows = (height + BitGrid::TILE_ROWS - 1) / BitGrid::TILE_ROWS;
+	for (int seed = 1; seed <= 8; seed++)
+	{
+		DoubleBuffer<BitGrid> replayed;
+		replayed.Front().SetTopology((ETopology)((seed - 1) % TOPOLOGY_COUNT));
+		replayed.Resize(width, height);
+
+		// blobs in every tile row, then (seeds 5 to 8) all in a single one, whose active tiles come in short runs
+		std::mt19937 random(seed);
+		for (int tileRow = 0; tileRow < tileRows; tileRow++)
+		{
+			if (seed > 4 && tileRow != tileRows / 2)
+				continue;
+
+			for (int blob = 0; blob < 8; blob++)
+			{
+				int top = tileRow * BitGrid::TILE_ROWS + random() % BitGrid::TILE_ROWS, left = random() % width;
+				for (int row = top; row < std::min(top + 8, height); row++)
+					for (int column = left; column < std::min(left + 8, width); column++)
+						replayed.Front().Set(row, column, random() % 2 == 0);
+			}
+		}
+
+		BitGrid a = replayed.Front(), b = a;
+		BitGrid* src = &a;
+		BitGrid* dst = &b;
+		for (int generation = 1; generation <= generations; generation++)
+		{
+			replayed.Step();
+			src->NextGeneration(*dst);
+			std::swap(src, dst);
+
+			for (int row = 0; row < height; row++)
+				if (!std::equal(src->Row(row), src->Row(row) + src->GetWordsPerRow(), replayed.Front().Row(row)))
+					return generation;
+		}
+	}
+	return -1;
+}
+
+bool LifeKernels::SelfTest()
+{
+	EStepKernel previous = Selected;
+	std::cout << "Self-test: " << Rule.ToString() << std::endl;
+
+	bool passed = true;
+	for (int kernel = 0; kernel < KERNEL_COUNT; kernel++)
+	{
+		if (!Select((EStepKernel)kernel))
+			continue;
+
+		// tiles replayed from the generation before must give the board a full step gives
+		int mismatch = CheckReplay();
+		if (mismatch >= 0)
+			std::cout << "  " << GetName((EStepKernel)kernel) << ": the tiles replayed from the back board differ from a full step at generation " << mismatch << std::endl;
+		else
+			std::cout << "  " << GetName((EStepKernel)kernel) << ": ok" << std::endl;
+		passed = passed && mismatch < 0;
+	}
+
+	Select(previous);
+	return passed;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "LifeRule.h"
+
+class BitGrid;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LIFE_KERNELS_X86
+#endif
+
+// bit-parallel step kernels from slowest to widest, then the block lookup kernel (never picked on its own)
+enum EStepKernel
+{
+	KERNEL_SCALAR,
+	KERNEL_SSE2,
+	KERNEL_AVX2,
+	KERNEL_AVX512,
+	KERNEL_LOOKUP,
+	KERNEL_COUNT
+};
+
+// steps words [wordBegin, wordEnd) of rowCount rows of a BitGrid under rule, src and dst point at the first row
+typedef void (*StepKernel)(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+
+// kernel entry points, every SIMD kernel lives in its own translation unit compiled for its instruction set
+void StepRowsScalar(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+void StepRowsLookup(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+#ifdef LIFE_KERNELS_X86
+void StepRowsSSE2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+void StepRowsAVX2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+void StepRowsAVX512(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+#endif
+
+// steps words [wordBegin, wordEnd) of an elementary rule row (see ElementaryKernel in LifeKernelTemplate.h)
+typedef void (*ElementaryKernelFunc)(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd);
+
+void StepElementaryScalar(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd);
+#ifdef LIFE_KERNELS_X86
+void StepElementarySSE2(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd);
+void StepElementaryAVX2(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd);
+void StepElementaryAVX512(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd);
+#endif
+
+// steps groups [groupBegin, groupEnd) of boards bit-sliced across words (see EnsembleKernel in LifeKernelTemplate.h)
+typedef void (*EnsembleKernelFunc)(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled);
+
+void StepEnsembleScalar(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled);
+#ifdef LIFE_KERNELS_X86
+void StepEnsembleSSE2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled);
+void StepEnsembleAVX2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled);
+void StepEnsembleAVX512(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled);
+#endif
+
+// steps words [wordBegin, wordEnd) of the 2x2 blocks of a pair of rows under a Margolus rule (see MargolusKernel in
+// LifeKernelTemplate.h)
+typedef void (*MargolusKernelFunc)(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd);
+
+void StepMargolusScalar(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd);
+#ifdef LIFE_KERNELS_X86
+void StepMargolusSSE2(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd);
+void StepMargolusAVX2(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd);
+void StepMargolusAVX512(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd);
+#endif
+
+// 4x4 -> 2x2 table of the lookup kernel, rebuilt only when the rule changes
+void BuildLookupTable(const LifeRule& rule);
+
+class LifeKernels
+{
+public:
+	// pick the widest kernel the host supports, or the one named by name ("scalar", "sse2", "avx2", "avx512", "lookup")
+	static void Init(const std::string& name);
+
+	// CPUID queries
+	static bool IsSupported(EStepKernel kernel);
+	static EStepKernel DetectBest();
+
+	// force a kernel, returns false if the host cannot run it
+	static bool Select(EStepKernel kernel);
+	static EStepKernel GetSelected();
+
+	// kernel names
+	static const char* GetName(EStepKernel kernel);
+	static bool FindByName(const std::string& name, EStepKernel& kernel);
+
+	// rule applied by every step
+	static void SetRule(const LifeRule& rule);
+	static const LifeRule& GetRule();
+
+	// step rows [rowBegin, rowEnd) of src into dst with the selected kernel
+	static void StepRows(const BitGrid& src, BitGrid& dst, int rowBegin, int rowEnd);
+
+	// same for words [wordBegin, wordEnd) of those rows only
+	static void StepRegion(const BitGrid& src, BitGrid& dst, int rowBegin, int rowEnd, int wordBegin, int wordEnd);
+
+	// same for rowCount rows of any buffer laid out like a BitGrid row range (see LifeKernelTemplate.h), all their
+	// words or words [wordBegin, wordEnd) only
+	static void StepBuffer(const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount);
+	static void StepBuffer(const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd);
+
+	// step words [wordBegin, wordEnd) of an elementary rule row on the selected instruction set (scalar for lookup)
+	static void StepElementary(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd) { ElementaryKernel(table, src, dst, wordBegin, wordEnd); }
+
+	// step groups [groupBegin, groupEnd) of an ensemble under the rule on the selected instruction set (scalar for lookup)
+	static void StepEnsemble(const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+	{
+		EnsembleKernel(Rule, src, dst, rowStride, slotWords, width, height, groupBegin, groupEnd, changed, cycled);
+	}
+
+	// step the blocks of words [wordBegin, wordEnd) of a pair of rows under a Margolus rule on the selected instruction
+	// set (scalar for lookup)
+	static void StepMargolus(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+	{
+		MargolusKernel(table, top, bottom, outTop, outBottom, scratch, wordBegin, wordEnd, odd);
+	}
+
+	// time every supported kernel on a random width x height board and print the results, one generation per
+	// pass over the board and, when timeBlock > 1, timeBlock generations per pass (see BitGrid::NextGenerations)
+	static void Benchmark(int width, int height, int generations, int timeBlock);
+
+	// check every supported kernel steps boards through a DoubleBuffer, whose quiet and asleep tiles are left to
+	// the back board, like whole boards, print the results and return whether they all do
+	static bool SelfTest();
+
+private:
+	static EStepKernel Selected;
+	static StepKernel Kernel;
+	static ElementaryKernelFunc ElementaryKernel;
+	static EnsembleKernelFunc EnsembleKernel;
+	static MargolusKernelFunc MargolusKernel;
+	static LifeRule Rule;
+};
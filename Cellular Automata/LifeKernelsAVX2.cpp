@@ -0,0 +1,48 @@
+#include "LifeKernels.h"
+
+#ifdef LIFE_KERNELS_X86
+
+// this file is compiled with /arch:AVX2 (-mavx2), it must only run after LifeKernels::IsSupported
+#include <immintrin.h>
+
+#include "LifeKernelTemplate.h"
+
+namespace
+{
+	struct AVX2Lanes
+	{
+		typedef __m256i Vec;
+		static const int WORDS = 4;
+
+		static inline Vec Load(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+		static inline void Store(uint64_t* p, Vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+		static inline Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+		static inline Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+		static inline Vec Xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+		static inline Vec AndNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+		template <int N> static inline Vec ShiftLeft(Vec a) { return _mm256_slli_epi64(a, N); }
+		template <int N> static inline Vec ShiftRight(Vec a) { return _mm256_srli_epi64(a, N); }
+	};
+}
+
+void StepRowsAVX2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	LifeKernel<AVX2Lanes>::StepRows(rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+}
+
+void StepElementaryAVX2(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd)
+{
+	ElementaryKernel<AVX2Lanes>::StepWords(table, src, dst, wordBegin, wordEnd);
+}
+
+void StepEnsembleAVX2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+{
+	EnsembleKernel<AVX2Lanes>::StepGroups(rule, src, dst, rowStride, slotWords, width, height, groupBegin, groupEnd, changed, cycled);
+}
+
+void StepMargolusAVX2(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+{
+	MargolusKernel<AVX2Lanes>::StepRows(table, top, bottom, outTop, outBottom, scratch, wordBegin, wordEnd, odd);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "LifeKernels.h"
+
+#ifdef LIFE_KERNELS_X86
+
+// this file is compiled with /arch:AVX512 (-mavx512f), it must only run after LifeKernels::IsSupported
+#include <immintrin.h>
+
+#include "LifeKernelTemplate.h"
+
+namespace
+{
+	struct AVX512Lanes
+	{
+		typedef __m512i Vec;
+		static const int WORDS = 8;
+
+		static inline Vec Load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+		static inline void Store(uint64_t* p, Vec v) { _mm512_storeu_si512(p, v); }
+		static inline Vec And(Vec a, Vec b) { return _mm512_and_si512(a, b); }
+		static inline Vec Or(Vec a, Vec b) { return _mm512_or_si512(a, b); }
+		static inline Vec Xor(Vec a, Vec b) { return _mm512_xor_si512(a, b); }
+		static inline Vec AndNot(Vec a, Vec b) { return _mm512_andnot_si512(a, b); }
+		template <int N> static inline Vec ShiftLeft(Vec a) { return _mm512_slli_epi64(a, N); }
+		template <int N> static inline Vec ShiftRight(Vec a) { return _mm512_srli_epi64(a, N); }
+	};
+}
+
+void StepRowsAVX512(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	LifeKernel<AVX512Lanes>::StepRows(rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+}
+
+void StepElementaryAVX512(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd)
+{
+	ElementaryKernel<AVX512Lanes>::StepWords(table, src, dst, wordBegin, wordEnd);
+}
+
+void StepEnsembleAVX512(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+{
+	EnsembleKernel<AVX512Lanes>::StepGroups(rule, src, dst, rowStride, slotWords, width, height, groupBegin, groupEnd, changed, cycled);
+}
+
+void StepMargolusAVX512(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+{
+	MargolusKernel<AVX512Lanes>::StepRows(table, top, bottom, outTop, outBottom, scratch, wordBegin, wordEnd, odd);
+}
+
+#endif
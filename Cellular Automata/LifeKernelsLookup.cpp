@@ -0,0 +1,108 @@
+#include "LifeKernels.h"
+
+#include <vector>
+
+/*
+
+	Block lookup kernel: a 65536-entry table maps every 4x4 square (bit 4 * row + column) to the next state
+	of its 2x2 center (bit 2 * row + column), so two rows are stepped 2x2 cells per table load. The table is
+	generated for the rule it is used with. Neighbourhoods reaching past the 3x3 square do not fit in a 4x4
+	square and run on the scalar kernel instead.
+
+*/
+
+static std::vector<uint8_t> BlockTable;
+static LifeRule BlockTableRule;
+
+void BuildLookupTable(const LifeRule& rule)
+{
+	if ((!BlockTable.empty() && rule == BlockTableRule) || rule.GetReach() > 1)
+		return;
+
+	BlockTable.assign(1 << 16, 0);
+	BlockTableRule = rule;
+
+	for (unsigned int cells = 0; cells < (1u << 16); cells++)
+	{
+		uint8_t next = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int row = 1 + i / 2, column = 1 + i % 2;
+
+			int LivingCells = 0;
+			for (int dx = -1; dx <= 1; dx++)
+				for (int dy = -1; dy <= 1; dy++)
+					if (rule.HasNeighbour(dx, dy))
+						LivingCells += (cells >> (4 * (row + dx) + column + dy)) & 1;
+
+			bool alive = (cells >> (4 * row + column)) & 1;
+			if (rule.Next(alive, LivingCells))
+				next |= 1 << i;
+		}
+		BlockTable[cells] = next;
+	}
+}
+
+void StepRowsLookup(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	if (rule.GetReach() > 1)
+	{
+		StepRowsScalar(rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+		return;
+	}
+
+	// built by LifeKernels before any step, never while the workers run
+	const uint8_t* table = BlockTable.data();
+
+	for (int row = 0; row < rowCount; row += 2)
+	{
+		// an odd last row only writes the top half of its blocks, its bottom row is never read past
+		bool pair = row + 1 < rowCount;
+		const uint64_t* rows[4] = { src + (row - 1) * stride, src + row * stride, src + (row + 1) * stride, nullptr };
+		rows[3] = pair ? src + (row + 2) * stride : rows[2];
+
+		uint64_t* top = dst + row * stride;
+		uint64_t* bottom = dst + (row + 1) * stride;
+
+		for (int w = wordBegin; w < wordEnd; w++)
+		{
+			// columns -1..62 of the word for blocks 0..30, and columns 61..64 for block 31
+			uint64_t shifted[4], last[4];
+			for (int i = 0; i < 4; i++)
+			{
+				shifted[i] = (rows[i][w] << 1) | (rows[i][w - 1] >> 63);
+				last[i] = (rows[i][w] >> 61) | ((rows[i][w + 1] & 1) << 3);
+			}
+
+			uint64_t topNext = 0, bottomNext = 0;
+			for (int block = 0; block < 32; block++)
+			{
+				unsigned int index;
+				if (block < 31)
+				{
+					index = (unsigned int)((shifted[0] >> (2 * block)) & 0xF) | (unsigned int)((shifted[1] >> (2 * block)) & 0xF) << 4 |
+							(unsigned int)((shifted[2] >> (2 * block)) & 0xF) << 8 | (unsigned int)((shifted[3] >> (2 * block)) & 0xF) << 12;
+				}
+				else
+				{
+					index = (unsigned int)last[0] | (unsigned int)last[1] << 4 | (unsigned int)last[2] << 8 | (unsigned int)last[3] << 12;
+				}
+
+				uint64_t next = table[index];
+				topNext |= (next & 3) << (2 * block);
+				bottomNext |= (next >> 2) << (2 * block);
+			}
+
+			// columns past the right edge are outside the board
+			if (w == wordsPerRow - 1)
+			{
+				topNext &= lastWordMask;
+				bottomNext &= lastWordMask;
+			}
+
+			top[w] = topNext;
+			if (pair)
+				bottom[w] = bottomNext;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#include "LifeKernels.h"
+
+#ifdef LIFE_KERNELS_X86
+
+#include <emmintrin.h>
+
+#include "LifeKernelTemplate.h"
+
+namespace
+{
+	struct SSE2Lanes
+	{
+		typedef __m128i Vec;
+		static const int WORDS = 2;
+
+		static inline Vec Load(const uint64_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+		static inline void Store(uint64_t* p, Vec v) { _mm_storeu_si128((__m128i*)p, v); }
+		static inline Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+		static inline Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+		static inline Vec Xor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+		static inline Vec AndNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+		template <int N> static inline Vec ShiftLeft(Vec a) { return _mm_slli_epi64(a, N); }
+		template <int N> static inline Vec ShiftRight(Vec a) { return _mm_srli_epi64(a, N); }
+	};
+}
+
+void StepRowsSSE2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t stride, int wordsPerRow, uint64_t lastWordMask, int rowCount, int wordBegin, int wordEnd)
+{
+	LifeKernel<SSE2Lanes>::StepRows(rule, src, dst, stride, wordsPerRow, lastWordMask, rowCount, wordBegin, wordEnd);
+}
+
+void StepElementarySSE2(const uint64_t* table, const uint64_t* src, uint64_t* dst, int wordBegin, int wordEnd)
+{
+	ElementaryKernel<SSE2Lanes>::StepWords(table, src, dst, wordBegin, wordEnd);
+}
+
+void StepEnsembleSSE2(const LifeRule& rule, const uint64_t* src, uint64_t* dst, ptrdiff_t rowStride, int slotWords, int width, int height, int groupBegin, int groupEnd, uint64_t* changed, uint64_t* cycled)
+{
+	EnsembleKernel<SSE2Lanes>::StepGroups(rule, src, dst, rowStride, slotWords, width, height, groupBegin, groupEnd, changed, cycled);
+}
+
+void StepMargolusSSE2(const uint64_t* table, const uint64_t* top, const uint64_t* bottom, uint64_t* outTop, uint64_t* outBottom, uint64_t* scratch, int wordBegin, int wordEnd, bool odd)
+{
+	MargolusKernel<SSE2Lanes>::StepRows(table, top, bottom, outTop, outBottom, scratch, wordBegin, wordEnd, odd);
+}
+
+#endif
@@ -0,0 +1,729 @@
+#include "LifeRule.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+
+// Instantiate static variables
+const int GenerationsRule::MAX_STATES;
+const int LargerThanLifeRule::MAX_RADIUS;
+const int LeniaRule::MAX_RADIUS;
+const int VoxelRule::MAX_NEIGHBOURS;
+
+struct NamedRule
+{
+	const char* Name;
+	unsigned int Birth;
+	unsigned int Survival;
+	ERuleKernel Kernel;
+};
+
+static const NamedRule KnownRules[] = {
+	{ "life",			RULE_MASK_B3,		RULE_MASK_S23,		RULE_LIFE },
+	{ "highlife",		RULE_MASK_B36,		RULE_MASK_S23,		RULE_HIGHLIFE },
+	{ "daynight",		RULE_MASK_B3678,	RULE_MASK_S34678,	RULE_DAY_AND_NIGHT },
+	{ "seeds",			RULE_MASK_B2,		RULE_MASK_S,		RULE_SEEDS },
+	{ "replicator",		RULE_MASK_B1357,	RULE_MASK_S1357,	RULE_REPLICATOR }
+};
+
+LifeRule::LifeRule()
+	: LifeRule(RULE_MASK_B3, RULE_MASK_S23)
+{
+
+}
+
+// B0 is dropped, see LifeRule.h, and so are counts larger than the neighbourhood
+LifeRule::LifeRule(unsigned int birth, unsigned int survival, unsigned int neighbourhood)
+	: Birth(0), Survival(0), Neighbourhood(neighbourhood & NEIGHBOURHOOD_MASK_5X5), Kernel(RULE_GENERIC)
+{
+	unsigned int counts = (2u << GetNeighbourCount()) - 1;
+	Birth = birth & counts & ~1u;
+	Survival = survival & counts;
+
+	// the specialized kernels are Moore only
+	if (Neighbourhood == NEIGHBOURHOOD_MOORE)
+		for (const NamedRule& known : KnownRules)
+			if (known.Birth == Birth && known.Survival == Survival)
+				Kernel = known.Kernel;
+}
+
+int LifeRule::GetNeighbourCount() const
+{
+	int count = 0;
+	for (unsigned int mask = Neighbourhood; mask; mask &= mask - 1)
+		count++;
+	return count;
+}
+
+// digits of one half of a rulestring into a neighbour mask
+static bool ParseCounts(const std::string& digits, unsigned int& mask)
+{
+	mask = 0;
+	for (char c : digits)
+	{
+		if (c < '0' || c > '8')
+			return false;
+		mask |= 1u << (c - '0');
+	}
+	return true;
+}
+
+// split the neighbourhood suffix ("v", "h" or "n@" and a hex mask) off the end of a lowercase rulestring
+static bool SplitNeighbourhood(std::string& text, unsigned int& neighbourhood)
+{
+	neighbourhood = NEIGHBOURHOOD_MOORE;
+
+	size_t at = text.find("n@");
+	if (at != std::string::npos)
+	{
+		std::string digits = text.substr(at + 2);
+		if (digits.empty() || digits.size() > 7 || digits.find_first_not_of("0123456789abcdef") != std::string::npos)
+			return false;
+
+		// the center is never a neighbour, and a cell needs at least one
+		neighbourhood = (unsigned int)std::stoul(digits, nullptr, 16);
+		if ((neighbourhood & ~NEIGHBOURHOOD_MASK_5X5) != 0 || neighbourhood == 0)
+			return false;
+
+		text = text.substr(0, at);
+	}
+	else if (!text.empty() && text.back() == 'v')
+	{
+		neighbourhood = NEIGHBOURHOOD_VON_NEUMANN;
+		text.pop_back();
+	}
+	else if (!text.empty() && text.back() == 'h')
+	{
+		neighbourhood = NEIGHBOURHOOD_HEX;
+		text.pop_back();
+	}
+	return true;
+}
+
+// rule with the given neighbourhood, false if a count of rule is larger than the neighbourhood
+static bool WithNeighbourhood(LifeRule& rule, unsigned int neighbourhood)
+{
+	LifeRule result(rule.Birth, rule.Survival, neighbourhood);
+	if (result.Birth != rule.Birth || result.Survival != rule.Survival)
+		return false;
+
+	rule = result;
+	return true;
+}
+
+bool LifeRule::Parse(const std::string& text, LifeRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	for (const NamedRule& known : KnownRules)
+	{
+		if (lower == known.Name)
+		{
+			rule = LifeRule(known.Birth, known.Survival);
+			return true;
+		}
+	}
+
+	unsigned int neighbourhood;
+	if (!SplitNeighbourhood(lower, neighbourhood))
+		return false;
+
+	size_t slash = lower.find('/');
+	if (slash == std::string::npos)
+		return false;
+
+	std::string first = lower.substr(0, slash);
+	std::string second = lower.substr(slash + 1);
+
+	unsigned int birth, survival;
+	if (!first.empty() && first[0] == 'b' && !second.empty() && second[0] == 's')				// B3/S23
+	{
+		if (!ParseCounts(first.substr(1), birth) || !ParseCounts(second.substr(1), survival))
+			return false;
+	}
+	else if (!first.empty() && first[0] == 's' && !second.empty() && second[0] == 'b')			// S23/B3
+	{
+		if (!ParseCounts(first.substr(1), survival) || !ParseCounts(second.substr(1), birth))
+			return false;
+	}
+	else																						// 23/3
+	{
+		if (!ParseCounts(first, survival) || !ParseCounts(second, birth))
+			return false;
+	}
+
+	if (birth & 1)
+		return false;
+
+	LifeRule parsed(birth, survival);
+	if (!WithNeighbourhood(parsed, neighbourhood))
+		return false;
+
+	rule = parsed;
+	return true;
+}
+
+std::string LifeRule::ToString() const
+{
+	std::string text = "B";
+	for (int n = 0; n <= 8; n++)
+		if ((Birth >> n) & 1)
+			text += (char)('0' + n);
+
+	text += "/S";
+	for (int n = 0; n <= 8; n++)
+		if ((Survival >> n) & 1)
+			text += (char)('0' + n);
+
+	return text + NeighbourhoodSuffix();
+}
+
+std::string LifeRule::NeighbourhoodSuffix() const
+{
+	if (Neighbourhood == NEIGHBOURHOOD_MOORE)
+		return "";
+	if (Neighbourhood == NEIGHBOURHOOD_VON_NEUMANN)
+		return "V";
+	if (Neighbourhood == NEIGHBOURHOOD_HEX)
+		return "H";
+
+	static const char digits[] = "0123456789ABCDEF";
+	std::string mask;
+	for (unsigned int value = Neighbourhood; value; value >>= 4)
+		mask.insert(mask.begin(), digits[value & 0xF]);
+	return "N@" + mask;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Generations
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct NamedGenerationsRule
+{
+	const char* Name;
+	const char* Rule;
+};
+
+static const NamedGenerationsRule KnownGenerationsRules[] = {
+	{ "brianbrain",		"/2/3" },
+	{ "starwars",		"345/2/4" },
+	{ "frogs",			"12/34/3" },
+	{ "lava",			"12345/45/8" }
+};
+
+GenerationsRule::GenerationsRule()
+	: States(2)
+{
+
+}
+
+bool GenerationsRule::Parse(const std::string& text, GenerationsRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	for (const NamedGenerationsRule& known : KnownGenerationsRules)
+		if (lower == known.Name)
+			return Parse(known.Rule, rule);
+
+	// S/B or Bx/Sy alone: Life-like
+	size_t last = lower.rfind('/');
+	if (last == std::string::npos || lower.find('/') == last)
+	{
+		GenerationsRule parsed;
+		if (!LifeRule::Parse(lower, parsed.Life))
+			return false;
+
+		rule = parsed;
+		return true;
+	}
+
+	// the neighbourhood comes after the state count ("12/34/3H")
+	unsigned int neighbourhood;
+	if (!SplitNeighbourhood(lower, neighbourhood))
+		return false;
+
+	// S/B/C or B/S/C, the state count optionally prefixed with C
+	std::string states = lower.substr(last + 1);
+	if (!states.empty() && states[0] == 'c')
+		states = states.substr(1);
+	if (states.empty() || states.size() > 2 || states.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	GenerationsRule parsed;
+	parsed.States = std::stoi(states);
+	if (parsed.States < 2 || parsed.States > MAX_STATES)
+		return false;
+
+	// "/2" alone is a valid S/B half: no survival, birth on 2
+	if (!LifeRule::Parse(lower.substr(0, last), parsed.Life) || !WithNeighbourhood(parsed.Life, neighbourhood))
+		return false;
+
+	rule = parsed;
+	return true;
+}
+
+std::string GenerationsRule::ToString() const
+{
+	if (States == 2)
+		return Life.ToString();
+
+	std::string text;
+	for (int n = 0; n <= 8; n++)
+		if ((Life.Survival >> n) & 1)
+			text += (char)('0' + n);
+
+	text += "/";
+	for (int n = 0; n <= 8; n++)
+		if ((Life.Birth >> n) & 1)
+			text += (char)('0' + n);
+
+	return text + "/" + std::to_string(States) + Life.NeighbourhoodSuffix();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Larger than Life
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LargerThanLifeRule::LargerThanLifeRule()
+	: Radius(5), CountSelf(true), SurviveMin(34), SurviveMax(58), BirthMin(34), BirthMax(45)
+{
+
+}
+
+// "34..58" or "34-58" into min, max
+static bool ParseRange(const std::string& text, int& min, int& max)
+{
+	size_t dots = text.find("..");
+	size_t length = 2;
+	if (dots == std::string::npos)
+	{
+		dots = text.find('-');
+		length = 1;
+	}
+	if (dots == std::string::npos || dots == 0 || dots + length >= text.size())
+		return false;
+
+	std::string first = text.substr(0, dots);
+	std::string second = text.substr(dots + length);
+	if (first.find_first_not_of("0123456789") != std::string::npos || second.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	if (first.size() > 4 || second.size() > 4)
+		return false;
+
+	min = std::stoi(first);
+	max = std::stoi(second);
+	return min <= max;
+}
+
+bool LargerThanLifeRule::Parse(const std::string& text, LargerThanLifeRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	LargerThanLifeRule parsed;
+	bool radius = false, survive = false, birth = false;
+
+	size_t begin = 0;
+	while (begin <= lower.size())
+	{
+		size_t comma = lower.find(',', begin);
+		if (comma == std::string::npos)
+			comma = lower.size();
+		std::string field = lower.substr(begin, comma - begin);
+		begin = comma + 1;
+
+		if (field.size() < 2)
+			return false;
+
+		std::string value = field.substr(1);
+		bool number = value.size() <= 4 && value.find_first_not_of("0123456789") == std::string::npos;
+
+		switch (field[0])
+		{
+		case 'r':
+			if (!number)
+				return false;
+			parsed.Radius = std::stoi(value);
+			radius = true;
+			break;
+		case 'c':
+			if (!number || (std::stoi(value) != 0 && std::stoi(value) != 2))
+				return false;
+			break;
+		case 'm':
+			if (value != "0" && value != "1")
+				return false;
+			parsed.CountSelf = (value == "1");
+			break;
+		case 's':
+			if (!ParseRange(value, parsed.SurviveMin, parsed.SurviveMax))
+				return false;
+			survive = true;
+			break;
+		case 'b':
+			if (!ParseRange(value, parsed.BirthMin, parsed.BirthMax))
+				return false;
+			birth = true;
+			break;
+		case 'n':
+			if (value != "m")
+				return false;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	if (!radius || !survive || !birth || parsed.Radius < 1 || parsed.Radius > MAX_RADIUS || parsed.BirthMin == 0)
+		return false;
+
+	rule = parsed;
+	return true;
+}
+
+std::string LargerThanLifeRule::ToString() const
+{
+	return "R" + std::to_string(Radius) + ",C0,M" + (CountSelf ? "1" : "0") + ",S" + std::to_string(SurviveMin) + ".." + std::to_string(SurviveMax) +
+		   ",B" + std::to_string(BirthMin) + ".." + std::to_string(BirthMax) + ",NM";
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Lenia
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LeniaRule::LeniaRule()
+	: Radius(13), Steps(10), Mu(0.15f), Sigma(0.015f)
+{
+
+}
+
+// a positive decimal number, at most 10 characters
+static bool ParseDecimal(const std::string& text, float& value)
+{
+	if (text.empty() || text.size() > 10 || text.find_first_not_of("0123456789.") != std::string::npos || text.find('.') != text.rfind('.') || text == ".")
+		return false;
+
+	value = std::stof(text);
+	return true;
+}
+
+bool LeniaRule::Parse(const std::string& text, LeniaRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	if (lower == "lenia" || lower == "orbium")
+	{
+		rule = LeniaRule();
+		return true;
+	}
+
+	if (lower.compare(0, 6, "lenia:") != 0)
+		return false;
+
+	LeniaRule parsed;
+	size_t begin = 6;
+	while (begin <= lower.size())
+	{
+		size_t comma = lower.find(',', begin);
+		if (comma == std::string::npos)
+			comma = lower.size();
+		std::string field = lower.substr(begin, comma - begin);
+		begin = comma + 1;
+
+		if (field.size() < 2)
+			return false;
+
+		float value;
+		if (!ParseDecimal(field.substr(1), value))
+			return false;
+
+		switch (field[0])
+		{
+		case 'r':	parsed.Radius = (int)value;		break;
+		case 't':	parsed.Steps = (int)value;		break;
+		case 'm':	parsed.Mu = value;				break;
+		case 's':	parsed.Sigma = value;			break;
+		default:	return false;
+		}
+	}
+
+	if (parsed.Radius < 1 || parsed.Radius > MAX_RADIUS || parsed.Steps < 1 || parsed.Sigma <= 0.0f)
+		return false;
+
+	rule = parsed;
+	return true;
+}
+
+std::string LeniaRule::ToString() const
+{
+	std::ostringstream text;
+	text << "lenia:R" << Radius << ",T" << Steps << ",M" << Mu << ",S" << Sigma;
+	return text.str();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Elementary
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ElementaryRule::ElementaryRule()
+	: Number(30)
+{
+
+}
+
+bool ElementaryRule::Parse(const std::string& text, ElementaryRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	std::string number;
+	if (lower.compare(0, 1, "w") == 0)
+		number = lower.substr(1);
+	else if (lower.compare(0, 4, "rule") == 0)
+		number = lower.substr(4);
+	else
+		return false;
+
+	if (number.empty() || number.size() > 3 || number.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	int value = std::stoi(number);
+	if (value > 255)
+		return false;
+
+	rule.Number = value;
+	return true;
+}
+
+std::string ElementaryRule::ToString() const
+{
+	return "W" + std::to_string(Number);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														3D
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VoxelRule::VoxelRule()
+	: Birth(1u << 5), Survival((1u << 4) | (1u << 5)), VonNeumann(false)
+{
+
+}
+
+// comma separated counts and ranges a-b, each at most maxCount
+static bool ParseCountList(const std::string& text, int maxCount, unsigned int& mask)
+{
+	mask = 0;
+	if (text.empty())
+		return true;
+
+	size_t begin = 0;
+	while (begin <= text.size())
+	{
+		size_t comma = text.find(',', begin);
+		if (comma == std::string::npos)
+			comma = text.size();
+		std::string item = text.substr(begin, comma - begin);
+		begin = comma + 1;
+
+		size_t dash = item.find('-');
+		std::string low = item.substr(0, dash);
+		std::string high = (dash == std::string::npos) ? low : item.substr(dash + 1);
+
+		for (const std::string& number : { low, high })
+			if (number.empty() || number.size() > 2 || number.find_first_not_of("0123456789") != std::string::npos)
+				return false;
+
+		int first = std::stoi(low), last = std::stoi(high);
+		if (first > last || last > maxCount)
+			return false;
+
+		for (int count = first; count <= last; count++)
+			mask |= 1u << count;
+	}
+
+	return true;
+}
+
+// inverse of ParseCountList
+static std::string CountListToString(unsigned int mask)
+{
+	std::string text;
+	for (int count = 0; count <= VoxelRule::MAX_NEIGHBOURS; count++)
+	{
+		if (!((mask >> count) & 1))
+			continue;
+
+		int last = count;
+		while (last < VoxelRule::MAX_NEIGHBOURS && ((mask >> (last + 1)) & 1))
+			last++;
+
+		if (!text.empty())
+			text += ",";
+		text += std::to_string(count);
+		if (last > count)
+			text += "-" + std::to_string(last);
+		count = last;
+	}
+	return text;
+}
+
+bool VoxelRule::Parse(const std::string& text, VoxelRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	VoxelRule parsed;
+	if (lower == "3d" || lower == "bays")
+	{
+		rule = parsed;
+		return true;
+	}
+
+	if (lower == "clouds")
+	{
+		parsed.Birth = (3u << 13) | (7u << 17);
+		parsed.Survival = ((1u << 27) - 1) & ~((1u << 13) - 1);
+		rule = parsed;
+		return true;
+	}
+
+	if (lower.compare(0, 3, "3d:") != 0)
+		return false;
+	lower = lower.substr(3);
+
+	if (!lower.empty() && lower.back() == 'v')
+	{
+		parsed.VonNeumann = true;
+		lower.pop_back();
+	}
+	else if (!lower.empty() && lower.back() == 'm')
+	{
+		lower.pop_back();
+	}
+
+	size_t slash = lower.find('/');
+	if (slash == std::string::npos || lower[0] != 'b' || lower.compare(slash + 1, 1, "s") != 0)
+		return false;
+
+	int maxCount = parsed.GetNeighbourCount();
+	if (!ParseCountList(lower.substr(1, slash - 1), maxCount, parsed.Birth) || !ParseCountList(lower.substr(slash + 2), maxCount, parsed.Survival))
+		return false;
+
+	if (parsed.Birth & 1)
+		return false;
+
+	rule = parsed;
+	return true;
+}
+
+std::string VoxelRule::ToString() const
+{
+	return "3d:B" + CountListToString(Birth) + "/S" + CountListToString(Survival) + (VonNeumann ? "V" : "");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Margolus
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct NamedBlockRule
+{
+	const char* Name;
+	int Next[16];
+};
+
+// Critters: a block of 2 living cells stays, any other is complemented, and turned around if it had 3. Billiard ball
+// model: a lone ball crosses its block diagonally, two meeting head-on leave on the other diagonal. Tron: a block of
+// equal cells is complemented
+static const NamedBlockRule KnownBlockRules[] = {
+	{ "critters",	{ 15, 14, 13, 3, 11, 5, 6, 1, 7, 9, 10, 2, 12, 4, 8, 0 } },
+	{ "bbm",		{ 0, 8, 4, 3, 2, 5, 9, 7, 1, 6, 10, 11, 12, 13, 14, 15 } },
+	{ "tron",		{ 15, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0 } }
+};
+
+MargolusRule::MargolusRule()
+{
+	std::copy(KnownBlockRules[0].Next, KnownBlockRules[0].Next + 16, Next);
+}
+
+bool MargolusRule::IsReversible() const
+{
+	int seen = 0;
+	for (int entry = 0; entry < 16; entry++)
+		seen |= 1 << Next[entry];
+	return seen == 0xFFFF;
+}
+
+bool MargolusRule::Parse(const std::string& text, MargolusRule& rule)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	if (lower == "billiard")
+		lower = "bbm";
+
+	for (const NamedBlockRule& known : KnownBlockRules)
+	{
+		if (lower == known.Name)
+		{
+			std::copy(known.Next, known.Next + 16, rule.Next);
+			return true;
+		}
+	}
+
+	if (lower.compare(0, 9, "margolus:") != 0)
+		return false;
+	lower = lower.substr(9);
+
+	// 16 entries, each a block
+	int next[16];
+	size_t begin = 0;
+	for (int entry = 0; entry < 16; entry++)
+	{
+		size_t comma = (entry < 15) ? lower.find(',', begin) : lower.size();
+		if (comma == std::string::npos)
+			return false;
+
+		std::string number = lower.substr(begin, comma - begin);
+		if (number.empty() || number.size() > 2 || number.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+
+		next[entry] = std::stoi(number);
+		if (next[entry] > 15)
+			return false;
+		begin = comma + 1;
+	}
+
+	std::copy(next, next + 16, rule.Next);
+	return true;
+}
+
+std::string MargolusRule::ToString() const
+{
+	for (const NamedBlockRule& known : KnownBlockRules)
+		if (std::equal(Next, Next + 16, known.Next))
+			return known.Name;
+
+	std::string text = "margolus:";
+	for (int entry = 0; entry < 16; entry++)
+		text += (entry ? "," : "") + std::to_string(Next[entry]);
+	return text;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+// neighbourhood masks, bit 5 * (row + 2) + column + 2 is the cell at offset (row, column) (see LifeRule)
+const unsigned int NEIGHBOURHOOD_MOORE			= 0x0729C0;
+const unsigned int NEIGHBOURHOOD_VON_NEUMANN	= 0x022880;
+const unsigned int NEIGHBOURHOOD_HEX			= 0x0628C0;
+const unsigned int NEIGHBOURHOOD_MASK_3X3		= 0x0739C0;
+const unsigned int NEIGHBOURHOOD_MASK_5X5		= 0x1FFEFFF;
+
+// most neighbours a cell can have, the 5x5 square without its center
+const int MAX_NEIGHBOURS = 24;
+
+// rules with a kernel specialized at compile time, every other rule runs on the generic kernel
+enum ERuleKernel
+{
+	RULE_LIFE,
+	RULE_HIGHLIFE,
+	RULE_DAY_AND_NIGHT,
+	RULE_SEEDS,
+	RULE_REPLICATOR,
+	RULE_GENERIC
+};
+
+/*
+
+	Life-like rule Bx/Sy: a dead cell with n living neighbours is born if n is in x, a living cell with n living
+	neighbours survives if n is in y. Both sets are kept as masks (bit n = n neighbours), which is all the step
+	kernels look at.
+
+	The neighbours are the cells of the 5x5 square around a cell picked by Neighbourhood, bit 5 * (row + 2) +
+	column + 2 for the cell at offset (row, column), the center never included: Moore (the default), von Neumann
+	(suffix V), hexagonal (suffix H, the hex grid stored with every row shifted half a cell left of the one
+	above, as in Golly) or any other mask (suffix N@ and the mask in hex). Counts above 8 cannot be written in
+	the rulestring.
+
+	Rules with B0 are rejected: they turn the empty plane on, which the tile skipping, the unbounded board and
+	HashLife all rely on never happening.
+
+*/
+
+struct LifeRule
+{
+	// constructor, B3/S23
+	LifeRule();
+	LifeRule(unsigned int birth, unsigned int survival, unsigned int neighbourhood = NEIGHBOURHOOD_MOORE);
+
+	unsigned int Birth;
+	unsigned int Survival;
+	unsigned int Neighbourhood;
+	ERuleKernel Kernel;
+
+	// next state of one cell
+	bool Next(bool alive, int neighbours) const { return (((alive ? Survival : Birth) >> neighbours) & 1) != 0; }
+
+	// whether the cell at offset (row, column), both in [-2, 2], is a neighbour
+	bool HasNeighbour(int row, int column) const { return ((Neighbourhood >> (5 * (row + 2) + column + 2)) & 1) != 0; }
+
+	// size of the neighbourhood, and how far it reaches (1 inside the 3x3 square, else 2)
+	int GetNeighbourCount() const;
+	int GetReach() const { return (Neighbourhood & ~NEIGHBOURHOOD_MASK_3X3) ? 2 : 1; }
+
+	// "B36/S23", "b36/s23", "23/36" (S/B) or the name of a known rule ("highlife"), optionally followed by the
+	// neighbourhood ("B2/S34H"), returns false on bad input
+	static bool Parse(const std::string& text, LifeRule& rule);
+
+	// "B36/S23", with the neighbourhood suffix when it is not Moore
+	std::string ToString() const;
+
+	// "V", "H", "N@729C0" or nothing for Moore
+	std::string NeighbourhoodSuffix() const;
+
+	bool operator==(const LifeRule& other) const { return Birth == other.Birth && Survival == other.Survival && Neighbourhood == other.Neighbourhood; }
+	bool operator!=(const LifeRule& other) const { return !(*this == other); }
+};
+
+/*
+
+	Generations rule S/B/C: births and survival follow a Life-like rule, but a living cell that does not survive
+	fades through the refractory states 2 .. C-1 (one per generation) before it is dead again, and only dead
+	cells can be born. Only living cells (state 1) count as neighbours. C = 2 is the plain Life-like rule.
+
+*/
+
+struct GenerationsRule
+{
+	// constructor, B3/S23 with 2 states
+	GenerationsRule();
+
+	LifeRule Life;
+	int States;
+
+	// at most 4 bits of state per cell
+	static const int MAX_STATES = 16;
+
+	// "345/2/4" (S/B/C), "B2/S/C3", a Life-like rule (2 states) or the name of a known rule ("brianbrain"),
+	// returns false on bad input
+	static bool Parse(const std::string& text, GenerationsRule& rule);
+
+	// "345/2/4", or the Life-like rulestring when there are 2 states
+	std::string ToString() const;
+};
+
+/*
+
+	Larger than Life rule Rr,Cc,Mm,Sa..b,Bc..d,NM: the neighbourhood is the (2r+1)x(2r+1) square around a cell,
+	the cell itself counted when m is 1. A living cell survives with a..b living cells in it, a dead cell is
+	born with c..d. Only 2 states (C0 or C2) and the square (Moore, NM) neighbourhood are supported, and a
+	birth range starting at 0 is rejected like B0.
+
+*/
+
+struct LargerThanLifeRule
+{
+	// constructor, Bosco's rule R5,C0,M1,S34..58,B34..45,NM
+	LargerThanLifeRule();
+
+	int Radius;
+	bool CountSelf;
+	int SurviveMin, SurviveMax;
+	int BirthMin, BirthMax;
+
+	static const int MAX_RADIUS = 10;
+
+	// next state of one cell with count living cells in its neighbourhood (the cell included when CountSelf)
+	bool Next(bool alive, int count) const { return alive ? (SurviveMin <= count && count <= SurviveMax) : (BirthMin <= count && count <= BirthMax); }
+
+	// "R5,C0,M1,S34..58,B34..45,NM", returns false on bad input
+	static bool Parse(const std::string& text, LargerThanLifeRule& rule);
+
+	std::string ToString() const;
+};
+
+/*
+
+	Lenia rule: every cell holds a value in [0, 1]. Each step, the values are convolved with a ring kernel of
+	radius Radius, exp(4 - 1 / (r (1 - r))) at distance r * Radius and normalized to sum 1, and the result u
+	moves every cell by 1 / Steps * (2 exp(-(u - Mu)^2 / (2 Sigma^2)) - 1), clipped to [0, 1].
+
+*/
+
+struct LeniaRule
+{
+	// constructor, the Orbium rule R13,T10,M0.15,S0.015
+	LeniaRule();
+
+	int Radius;
+	int Steps;
+	float Mu;
+	float Sigma;
+
+	static const int MAX_RADIUS = 100;
+
+	// growth of a cell whose neighbourhood sums to u
+	float Growth(float u) const { float d = (u - Mu) / Sigma; return 2.0f * std::exp(-0.5f * d * d) - 1.0f; }
+
+	// "lenia", "orbium" or "lenia:R13,T10,M0.15,S0.015" (fields in any order, missing ones keep their default),
+	// returns false on bad input
+	static bool Parse(const std::string& text, LeniaRule& rule);
+
+	std::string ToString() const;
+};
+
+/*
+
+	Elementary rule (Wolfram's numbering): a row of cells where each one looks at itself and its left and right
+	neighbours. Bit 4 * left + 2 * center + right of Number is the next state for that neighbourhood, rule 30
+	is 00011110.
+
+*/
+
+struct ElementaryRule
+{
+	// constructor, rule 30
+	ElementaryRule();
+
+	int Number;
+
+	bool Next(bool left, bool center, bool right) const { return ((Number >> (4 * left + 2 * center + right)) & 1) != 0; }
+
+	// "W30" or "rule30", returns false on bad input
+	static bool Parse(const std::string& text, ElementaryRule& rule);
+
+	std::string ToString() const;
+};
+
+/*
+
+	3D Life-like rule 3d:Bx/Sy: bit n of Birth (Survival) is set when a dead (living) voxel with n living
+	neighbours is alive next generation. The neighbourhood is the 26 voxels of the 3x3x3 cube (Moore), or the
+	6 voxels sharing a face (von Neumann, a V after the rule). Counts are listed with commas and ranges, as in
+	3d:B13-14,17-19/S13-26, and B0 is rejected like for the 2D rules.
+
+*/
+
+struct VoxelRule
+{
+	// constructor, Bays' 3D Life B5/S4-5
+	VoxelRule();
+
+	unsigned int Birth;
+	unsigned int Survival;
+	bool VonNeumann;
+
+	static const int MAX_NEIGHBOURS = 26;
+
+	int GetNeighbourCount() const { return VonNeumann ? 6 : MAX_NEIGHBOURS; }
+
+	// "3d:B5/S4-5", "3d:B1/S1-3V" or a name: "3d" or "bays" (B5/S4-5), "clouds" (B13-14,17-19/S13-26),
+	// returns false on bad input
+	static bool Parse(const std::string& text, VoxelRule& rule);
+
+	std::string ToString() const;
+};
+
+/*
+
+	Margolus rule: the board is cut in 2x2 blocks, each replaced every generation by the entry of a 16-entry
+	table, and the blocks start at even rows and columns one generation and at odd ones the next. A block is
+	nw + 2 ne + 4 sw + 8 se (1 for a living cell), so Next[1] = 8 moves a lone cell from the north-west corner
+	to the south-east one. A table that is a permutation makes the rule reversible: the inverse table, applied
+	with the blocks of the generations in reverse order, runs the board back.
+
+*/
+
+struct MargolusRule
+{
+	// constructor, Critters
+	MargolusRule();
+
+	int Next[16];
+
+	bool IsReversible() const;
+
+	// a name: "critters", "bbm" or "billiard" (billiard ball model), "tron", or "margolus:" and the 16 entries
+	// separated by commas ("margolus:0,8,4,3,2,5,9,7,1,6,10,11,12,13,14,15"), returns false on bad input
+	static bool Parse(const std::string& text, MargolusRule& rule);
+
+	std::string ToString() const;
+};
+
+// compile-time birth/survival masks of the specialized rules
+const unsigned int RULE_MASK_B3				= 0x008;
+const unsigned int RULE_MASK_S23			= 0x00C;
+const unsigned int RULE_MASK_B36			= 0x048;
+const unsigned int RULE_MASK_B3678			= 0x1C8;
+const unsigned int RULE_MASK_S34678			= 0x1D8;
+const unsigned int RULE_MASK_B2				= 0x004;
+const unsigned int RULE_MASK_S				= 0x000;
+const unsigned int RULE_MASK_B1357			= 0x0AA;
+const unsigned int RULE_MASK_S1357			= 0x0AA;
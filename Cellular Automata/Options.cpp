@@ -0,0 +1,61 @@
+#include "Options.h"
+
+#include <cctype>
+#include <cstdlib>
+
+// Instantiate static variables
+std::map<std::string, std::string> Options::Values;
+
+void Options::Parse(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0)
+			continue;
+
+		size_t equal = arg.find('=');
+		if (equal == std::string::npos)
+			Values[arg.substr(2)] = "1";
+		else
+			Values[arg.substr(2, equal - 2)] = arg.substr(equal + 1);
+	}
+}
+
+std::string Options::Get(const std::string& name, const std::string& fallback)
+{
+	auto iter = Values.find(name);
+	if (iter != Values.end())
+		return iter->second;
+
+	// --kernel-name -> CA_KERNEL_NAME
+	std::string variable = "CA_";
+	for (char c : name)
+		variable += (c == '-') ? '_' : (char)std::toupper((unsigned char)c);
+
+#ifdef _MSC_VER
+	// getenv is rejected by /sdl
+	char* buffer = nullptr;
+	size_t length = 0;
+	if (_dupenv_s(&buffer, &length, variable.c_str()) == 0 && buffer != nullptr)
+	{
+		std::string value = buffer;
+		free(buffer);
+		return value;
+	}
+#else
+	const char* value = std::getenv(variable.c_str());
+	if (value != nullptr)
+		return value;
+#endif
+
+	return fallback;
+}
+
+int Options::GetInt(const std::string& name, int fallback)
+{
+	std::string value = Get(name);
+	if (value.empty())
+		return fallback;
+	return std::atoi(value.c_str());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <map>
+
+// command line options of the form --name=value, with the environment variable CA_NAME as fallback
+class Options
+{
+public:
+	// store the command line
+	static void Parse(int argc, char* argv[]);
+
+	// retrieve an option, or fallback if it is set neither on the command line nor in the environment
+	static std::string Get(const std::string& name, const std::string& fallback = "");
+	static int GetInt(const std::string& name, int fallback);
+
+private:
+	static std::map<std::string, std::string> Values;
+};
@@ -0,0 +1,455 @@
+#include "SoupSearch.h"
+#include "LifeKernels.h"
+#include "SparseUniverse.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+// generations the population has to repeat for at least, whatever its period
+static const int MIN_SETTLED_GENERATIONS = 20;
+
+// digits of the extended Wechsler format: a 5 cell column, and the length - 4 of a run of blank columns after y
+static const char* const STRIP_DIGITS = "0123456789abcdefghijklmnopqrstuv";
+static const char* const RUN_DIGITS = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+struct SoupSearch::Scratch
+{
+	SparseUniverse Soup;
+	SparseUniverse Object;
+	std::vector<uint64_t> Rows;
+	std::vector<int> Populations;
+};
+
+// next word of a splitmix64 stream
+static inline uint64_t SplitMix64(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static int GetPopulation(const SparseUniverse& board)
+{
+	int population = 0;
+	board.ForEachTile([&population](int64_t, int64_t, const uint64_t* rows) {
+		for (int r = 0; r < SparseUniverse::TILE_SIZE; r++)
+			population += PopCount(rows[r]);
+	});
+	return population;
+}
+
+static void GetCells(const SparseUniverse& board, std::vector<std::pair<int, int>>& cells)
+{
+	cells.clear();
+	board.ForEachTile([&cells](int64_t tileRow, int64_t tileColumn, const uint64_t* rows) {
+		for (int r = 0; r < SparseUniverse::TILE_SIZE; r++)
+		{
+			uint64_t bits = rows[r];
+			while (bits)
+			{
+				cells.emplace_back((int)(tileRow * SparseUniverse::TILE_SIZE + r), (int)(tileColumn * SparseUniverse::TILE_SIZE + CountTrailingZeros(bits)));
+				bits &= bits - 1;
+			}
+		}
+	});
+}
+
+// move cells to the top left corner of the plane in sorted order, the corner they were moved from in row, column
+static void Normalize(std::vector<std::pair<int, int>>& cells, int& row, int& column)
+{
+	row = column = 0;
+	if (cells.empty())
+		return;
+
+	row = cells[0].first;
+	column = cells[0].second;
+	for (const auto& cell : cells)
+	{
+		row = std::min(row, cell.first);
+		column = std::min(column, cell.second);
+	}
+
+	for (auto& cell : cells)
+	{
+		cell.first -= row;
+		cell.second -= column;
+	}
+	std::sort(cells.begin(), cells.end());
+}
+
+// extended Wechsler code of normalized cells
+static std::string WechslerCode(const std::vector<std::pair<int, int>>& cells)
+{
+	int height = 0, width = 0;
+	for (const auto& cell : cells)
+	{
+		height = std::max(height, cell.first + 1);
+		width = std::max(width, cell.second + 1);
+	}
+
+	int stripCount = (height + 4) / 5;
+	std::vector<int> strips((size_t)stripCount * width, 0);
+	for (const auto& cell : cells)
+		strips[(size_t)(cell.first / 5) * width + cell.second] |= 1 << (cell.first % 5);
+
+	std::string code;
+	for (int strip = 0; strip < stripCount; strip++)
+	{
+		if (strip > 0)
+			code += 'z';
+
+		// blank columns are written only once a living one follows
+		int blank = 0;
+		for (int column = 0; column < width; column++)
+		{
+			int value = strips[(size_t)strip * width + column];
+			if (value == 0)
+			{
+				blank++;
+				continue;
+			}
+
+			while (blank >= 40)
+			{
+				code += "yz";
+				blank -= 39;
+			}
+			if (blank >= 4)
+				code += std::string("y") + RUN_DIGITS[blank - 4];
+			else if (blank == 3)
+				code += 'x';
+			else if (blank == 2)
+				code += 'w';
+			else if (blank == 1)
+				code += '0';
+			blank = 0;
+
+			code += STRIP_DIGITS[value];
+		}
+	}
+	return code;
+}
+
+SoupSearch::SoupSearch()
+	: SoupSize(16), MaxGenerations(10000), SoupCount(0), ObjectCount(0), UnsettledCount(0)
+{
+
+}
+
+SoupSearch::~SoupSearch()
+{
+	for (Scratch* scratch : Scratches)
+		delete scratch;
+}
+
+void SoupSearch::SetSoupSize(int size)
+{
+	SoupSize = std::min(std::max(size, 1), 64);
+}
+
+void SoupSearch::SetMaxGenerations(int generations)
+{
+	MaxGenerations = std::max(generations, 1);
+}
+
+void SoupSearch::Clear()
+{
+	Census.clear();
+	SoupCount = 0;
+	ObjectCount = 0;
+	UnsettledCount = 0;
+}
+
+void SoupSearch::GetSoup(uint64_t seed, long long soup, std::vector<uint64_t>& rows) const
+{
+	uint64_t state = seed ^ ((uint64_t)soup * 0xD1B54A32D192ED03ULL);
+	uint64_t mask = (SoupSize == 64) ? ~0ULL : (1ULL << SoupSize) - 1;
+
+	rows.resize(SoupSize);
+	for (int r = 0; r < SoupSize; r++)
+		rows[r] = SplitMix64(state) & mask;
+}
+
+void SoupSearch::GetCensusByCount(std::vector<std::pair<std::string, CensusEntry>>& rows) const
+{
+	rows.assign(Census.begin(), Census.end());
+	std::stable_sort(rows.begin(), rows.end(), [](const std::pair<std::string, CensusEntry>& a, const std::pair<std::string, CensusEntry>& b) {
+		return a.second.Count > b.second.Count;
+	});
+}
+
+void SoupSearch::Run(uint64_t seed, long long firstSoup, long long soupCount, ThreadPool* pool)
+{
+	int threadCount = (pool != nullptr) ? pool->GetThreadCount() : 1;
+	while ((int)Scratches.size() < threadCount)
+		Scratches.push_back(new Scratch());
+
+	std::vector<SoupResult> results;
+	for (long long batchBegin = 0; batchBegin < soupCount; batchBegin += SOUPS_PER_BATCH)
+	{
+		int batchSize = (int)std::min<long long>(SOUPS_PER_BATCH, soupCount - batchBegin);
+		results.assign(batchSize, SoupResult());
+
+		// soups only write their own result
+		auto runSoup = [&](int index, int thread) {
+			RunSoup(seed, firstSoup + batchBegin + index, *Scratches[thread], results[index]);
+		};
+
+		if (pool == nullptr)
+		{
+			for (int index = 0; index < batchSize; index++)
+				runSoup(index, 0);
+		}
+		else
+		{
+			pool->RunStealing(batchSize, runSoup);
+		}
+
+		// counted in soup order, whichever thread ran which soup
+		for (int index = 0; index < batchSize; index++)
+		{
+			long long soup = firstSoup + batchBegin + index;
+			SoupCount++;
+			if (!results[index].Settled)
+			{
+				UnsettledCount++;
+				continue;
+			}
+
+			for (const std::string& name : results[index].Objects)
+			{
+				CensusEntry& entry = Census.emplace(name, CensusEntry{ 0, soup }).first->second;
+				entry.Count++;
+				entry.FirstSoup = std::min(entry.FirstSoup, soup);
+				ObjectCount++;
+			}
+		}
+	}
+}
+
+void SoupSearch::RunSoup(uint64_t seed, long long soup, Scratch& scratch, SoupResult& result) const
+{
+	SparseUniverse& board = scratch.Soup;
+	board.Clear();
+
+	GetSoup(seed, soup, scratch.Rows);
+	for (int r = 0; r < SoupSize; r++)
+		for (int c = 0; c < SoupSize; c++)
+			if ((scratch.Rows[r] >> c) & 1)
+				board.Set(r, c, true);
+
+	// settled once the population repeats with some period, whatever flies away
+	std::vector<int>& populations = scratch.Populations;
+	populations.assign(1, GetPopulation(board));
+
+	result.Settled = false;
+	for (int generation = 1; generation <= MaxGenerations && !result.Settled; generation++)
+	{
+		board.NextGeneration();
+		populations.push_back(GetPopulation(board));
+
+		int last = (int)populations.size() - 1;
+		for (int period = 1; period <= MAX_PERIOD && !result.Settled; period++)
+		{
+			int window = std::max(REPEATS * period, MIN_SETTLED_GENERATIONS);
+			if (window + period > last)
+				break;
+
+			result.Settled = true;
+			for (int k = 0; k < window && result.Settled; k++)
+				result.Settled = (populations[last - k] == populations[last - k - period]);
+		}
+	}
+
+	result.Objects.clear();
+	if (!result.Settled)
+		return;
+
+	CellList ash;
+	GetCells(board, ash);
+	SeparateObjects(ash, scratch, result.Objects);
+}
+
+void SoupSearch::SeparateObjects(const CellList& ash, Scratch& scratch, std::vector<std::string>& names) const
+{
+	int cellCount = (int)ash.size();
+	int reach = LifeKernels::GetRule().GetReach();
+
+	std::unordered_map<uint64_t, int> cellIndex;
+	auto key = [](int row, int column) { return ((uint64_t)(uint32_t)row << 32) | (uint32_t)column; };
+	for (int i = 0; i < cellCount; i++)
+		cellIndex[key(ash[i].first, ash[i].second)] = i;
+
+	// union-find over the cells
+	std::vector<int> parent(cellCount);
+	for (int i = 0; i < cellCount; i++)
+		parent[i] = i;
+
+	auto find = [&parent](int i) {
+		while (parent[i] != i)
+			i = parent[i] = parent[parent[i]];
+		return i;
+	};
+
+	// join every cell with the cells within distance of it, true if two groups became one
+	auto join = [&](int i, int distance) {
+		bool merged = false;
+		for (int dr = -distance; dr <= distance; dr++)
+		{
+			for (int dc = -distance; dc <= distance; dc++)
+			{
+				auto iter = cellIndex.find(key(ash[i].first + dr, ash[i].second + dc));
+				if (iter == cellIndex.end())
+					continue;
+
+				int a = find(i), b = find(iter->second);
+				if (a != b)
+				{
+					parent[std::max(a, b)] = std::min(a, b);
+					merged = true;
+				}
+			}
+		}
+		return merged;
+	};
+
+	for (int i = 0; i < cellCount; i++)
+		join(i, reach);
+
+	// names of the groups by root, valid while the group keeps its size (groups only grow)
+	std::unordered_map<int, std::pair<int, std::string>> named;
+	std::vector<CellList> groups;
+	std::vector<int> roots;
+
+	while (true)
+	{
+		std::unordered_map<int, int> groupOf;
+		groups.clear();
+		roots.clear();
+		for (int i = 0; i < cellCount; i++)
+		{
+			int root = find(i);
+			auto iter = groupOf.emplace(root, (int)groups.size()).first;
+			if (iter->second == (int)groups.size())
+			{
+				groups.emplace_back();
+				roots.push_back(root);
+			}
+			groups[iter->second].push_back(ash[i]);
+		}
+
+		// an empty name for the groups that are no object on their own
+		bool unnamed = false;
+		for (size_t g = 0; g < groups.size(); g++)
+		{
+			auto iter = named.find(roots[g]);
+			if (iter != named.end() && iter->second.first == (int)groups[g].size())
+			{
+				unnamed |= iter->second.second.empty();
+				continue;
+			}
+
+			std::string name;
+			if (!NameObject(groups[g], scratch.Object, name))
+				name.clear();
+			named[roots[g]] = std::make_pair((int)groups[g].size(), name);
+			unnamed |= name.empty();
+		}
+
+		// the cells of unnamed groups, taken before any of them joins another group
+		bool merged = false;
+		if (unnamed)
+		{
+			std::vector<int> loose;
+			for (int i = 0; i < cellCount; i++)
+				if (named[find(i)].second.empty())
+					loose.push_back(i);
+
+			for (int i : loose)
+				merged |= join(i, 2 * reach);
+		}
+
+		if (!merged)
+			break;
+	}
+
+	for (size_t g = 0; g < groups.size(); g++)
+	{
+		const std::string& name = named[roots[g]].second;
+		names.push_back(name.empty() ? "zz_unknown" : name);
+	}
+}
+
+bool SoupSearch::NameObject(const CellList& cells, SparseUniverse& board, std::string& name) const
+{
+	board.Clear();
+	for (const auto& cell : cells)
+		board.Set(cell.first, cell.second, true);
+
+	std::vector<CellList> phases(1, cells);
+	int startRow, startColumn;
+	Normalize(phases[0], startRow, startColumn);
+
+	// back to its own shape: the period, and whether it moved
+	int period = 0;
+	bool moved = false;
+	CellList current;
+	for (int generation = 1; generation <= MAX_PERIOD && period == 0; generation++)
+	{
+		board.NextGeneration();
+		GetCells(board, current);
+		if (current.empty() || current.size() > 4 * cells.size() + 64)
+			return false;
+
+		int row, column;
+		Normalize(current, row, column);
+		if (current == phases[0])
+		{
+			period = generation;
+			moved = (row != startRow || column != startColumn);
+		}
+		else
+		{
+			phases.push_back(current);
+		}
+	}
+
+	if (period == 0)
+		return false;
+
+	// shortest code, then the first in alphabetical order, over every phase and orientation
+	std::string best;
+	CellList oriented;
+	for (const CellList& phase : phases)
+	{
+		for (int orientation = 0; orientation < 8; orientation++)
+		{
+			oriented.clear();
+			for (const auto& cell : phase)
+			{
+				int row = (orientation & 1) ? -cell.first : cell.first;
+				int column = (orientation & 2) ? -cell.second : cell.second;
+				if (orientation & 4)
+					std::swap(row, column);
+				oriented.emplace_back(row, column);
+			}
+
+			int row, column;
+			Normalize(oriented, row, column);
+			std::string code = WechslerCode(oriented);
+			if (best.empty() || code.size() < best.size() || (code.size() == best.size() && code < best))
+				best = code;
+		}
+	}
+
+	if (moved)
+		name = "xq" + std::to_string(period);
+	else if (period == 1)
+		name = "xs" + std::to_string(cells.size());
+	else
+		name = "xp" + std::to_string(period);
+	name += "_" + best;
+	return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SparseUniverse;
+class ThreadPool;
+
+/*
+
+	Random soup search in the way of apgsearch: soup k of a seed is a SoupSize x SoupSize square of random
+	cells drawn from the seed and k only, run on an unbounded board under the rule of LifeKernels until its
+	population repeats with a period up to MAX_PERIOD (for REPEATS periods), so gliders flying away do not
+	keep a settled soup running. The ash left then is cut into objects and every object is named by a
+	canonical code and counted in the census.
+
+	Objects start as the groups of cells within the reach of the neighbourhood of each other. A group is run
+	on its own: it is an object if it comes back to its own shape within MAX_PERIOD generations, in place (a
+	still life, xs + population, or an oscillator, xp + period) or moved (a spaceship, xq + period). Groups
+	that are not (the parts of an oscillator whose phase falls apart, a spark) are merged with the groups
+	within twice the reach and tried again. The code after the prefix is the extended Wechsler encoding of the
+	object (columns of 5 cell strips as base 32 digits, w x y for runs of blank columns, z between strips),
+	shortest and then first in alphabetical order over all phases and the 8 orientations, so the same object
+	gets the same name wherever and however it turned up.
+
+	Soups run in batches of SOUPS_PER_BATCH on the thread pool with work stealing, each thread on its own
+	scratch boards. The objects of every soup are kept until the batch ends and then counted in soup order,
+	so the census (with the first soup each object was seen in) depends only on the seed and soup range.
+
+*/
+
+class SoupSearch
+{
+public:
+	// constructor
+	SoupSearch();
+	~SoupSearch();
+
+	// side of the soup square, at most 64 (default 16)
+	void SetSoupSize(int size);
+	int GetSoupSize() const { return SoupSize; }
+
+	// generations a soup may run before it is counted as unsettled (default 10000)
+	void SetMaxGenerations(int generations);
+
+	// run soups [firstSoup, firstSoup + soupCount) of seed and add their objects to the census
+	void Run(uint64_t seed, long long firstSoup, long long soupCount, ThreadPool* pool = nullptr);
+
+	// forget every soup run so far
+	void Clear();
+
+	struct CensusEntry
+	{
+		long long Count;
+		long long FirstSoup;
+	};
+
+	const std::map<std::string, CensusEntry>& GetCensus() const { return Census; }
+	long long GetSoupCount() const { return SoupCount; }
+	long long GetObjectCount() const { return ObjectCount; }
+
+	// soups still running after the generation limit, left out of the census
+	long long GetUnsettledCount() const { return UnsettledCount; }
+
+	// census rows by decreasing count
+	void GetCensusByCount(std::vector<std::pair<std::string, CensusEntry>>& rows) const;
+
+	// rows of soup k of seed, bit c of rows[r] being the cell at (r, c)
+	void GetSoup(uint64_t seed, long long soup, std::vector<uint64_t>& rows) const;
+
+	// longest period looked for, in populations and objects
+	static const int MAX_PERIOD = 60;
+
+	// periods the population has to repeat for before a soup counts as settled
+	static const int REPEATS = 4;
+
+	static const int SOUPS_PER_BATCH = 1024;
+
+private:
+	int SoupSize;
+	int MaxGenerations;
+
+	std::map<std::string, CensusEntry> Census;
+	long long SoupCount;
+	long long ObjectCount;
+	long long UnsettledCount;
+
+	// scratch boards of every thread: the soup and the object being named
+	struct Scratch;
+	std::vector<Scratch*> Scratches;
+
+	// objects of one soup, empty names and settled false if it did not settle
+	struct SoupResult
+	{
+		bool Settled;
+		std::vector<std::string> Objects;
+	};
+
+	typedef std::vector<std::pair<int, int>> CellList;
+
+	void RunSoup(uint64_t seed, long long soup, Scratch& scratch, SoupResult& result) const;
+
+	// split the ash into objects and name them
+	void SeparateObjects(const CellList& ash, Scratch& scratch, std::vector<std::string>& names) const;
+
+	// name of cells run on their own, false if they do not repeat within MAX_PERIOD generations
+	bool NameObject(const CellList& cells, SparseUniverse& board, std::string& name) const;
+};
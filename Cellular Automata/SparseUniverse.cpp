@@ -0,0 +1,259 @@
+#include "SparseUniverse.h"
+#include "LifeKernelTemplate.h"
+#include "LifeKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+// shared dead tile for missing neighbours
+static const uint64_t DeadRows[SparseUniverse::TILE_SIZE] = {};
+
+SparseUniverse::SparseUniverse()
+{
+
+}
+
+SparseUniverse::~SparseUniverse()
+{
+	Clear();
+	for (Tile* tile : FreeTiles)
+		delete tile;
+}
+
+void SparseUniverse::Clear()
+{
+	for (auto& iter : Tiles)
+		delete iter.second;
+	Tiles.clear();
+}
+
+uint64_t SparseUniverse::Key(int64_t tileRow, int64_t tileColumn)
+{
+	return ((uint64_t)(uint32_t)tileRow << 32) | (uint32_t)tileColumn;
+}
+
+const SparseUniverse::Tile* SparseUniverse::FindTile(int64_t tileRow, int64_t tileColumn) const
+{
+	auto iter = Tiles.find(Key(tileRow, tileColumn));
+	return (iter == Tiles.end()) ? nullptr : iter->second;
+}
+
+SparseUniverse::Tile* SparseUniverse::AllocateTile()
+{
+	if (FreeTiles.empty())
+		return new Tile();
+
+	Tile* tile = FreeTiles.back();
+	FreeTiles.pop_back();
+	return tile;
+}
+
+void SparseUniverse::ReleaseTile(Tile* tile)
+{
+	FreeTiles.push_back(tile);
+}
+
+bool SparseUniverse::Get(int64_t row, int64_t column) const
+{
+	const Tile* tile = FindTile(FloorDiv64(row), FloorDiv64(column));
+	if (tile == nullptr)
+		return false;
+
+	return (tile->Rows[row - FloorDiv64(row) * TILE_SIZE] >> (column - FloorDiv64(column) * TILE_SIZE)) & 1;
+}
+
+void SparseUniverse::Set(int64_t row, int64_t column, bool alive)
+{
+	uint64_t key = Key(FloorDiv64(row), FloorDiv64(column));
+	int r = (int)(row - FloorDiv64(row) * TILE_SIZE);
+	uint64_t bit = 1ULL << (column - FloorDiv64(column) * TILE_SIZE);
+
+	auto iter = Tiles.find(key);
+	if (iter == Tiles.end())
+	{
+		if (!alive)
+			return;
+
+		Tile* tile = AllocateTile();
+		std::memset(tile->Rows, 0, sizeof(tile->Rows));
+		iter = Tiles.emplace(key, tile).first;
+	}
+
+	Tile* tile = iter->second;
+	if (alive)
+	{
+		tile->Rows[r] |= bit;
+		return;
+	}
+
+	tile->Rows[r] &= ~bit;
+
+	// free the tile with its last cell
+	for (int i = 0; i < TILE_SIZE; i++)
+		if (tile->Rows[i] != 0)
+			return;
+
+	ReleaseTile(tile);
+	Tiles.erase(iter);
+}
+
+void SparseUniverse::SetTile(int64_t tileRow, int64_t tileColumn, const uint64_t* rows)
+{
+	uint64_t key = Key(tileRow, tileColumn);
+
+	bool empty = true;
+	for (int i = 0; i < TILE_SIZE && empty; i++)
+		empty = (rows[i] == 0);
+
+	auto iter = Tiles.find(key);
+	if (empty)
+	{
+		if (iter != Tiles.end())
+		{
+			ReleaseTile(iter->second);
+			Tiles.erase(iter);
+		}
+		return;
+	}
+
+	if (iter == Tiles.end())
+		iter = Tiles.emplace(key, AllocateTile()).first;
+	std::memcpy(iter->second->Rows, rows, sizeof(iter->second->Rows));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														Stepping
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Rule, typename Neighbourhood>
+void SparseUniverse::StepTile(const Rule& rule, const Neighbourhood& neighbourhood, uint64_t key, Tile* out) const
+{
+	int64_t tileRow = KeyRow(key), tileColumn = KeyColumn(key);
+
+	// 3x3 tile neighbourhood, missing tiles are dead
+	const uint64_t* around[3][3];
+	for (int dr = -1; dr <= 1; dr++)
+	{
+		for (int dc = -1; dc <= 1; dc++)
+		{
+			const Tile* tile = FindTile(tileRow + dr, tileColumn + dc);
+			around[dr + 1][dc + 1] = (tile != nullptr) ? tile->Rows : DeadRows;
+		}
+	}
+
+	typedef LifeKernel<ScalarLanes> Kernel;
+
+	// the row r of column block c, with rows < 0 and >= TILE_SIZE taken from the tiles above/below
+	auto word = [&](int r, int c) -> uint64_t {
+		if (r < 0)
+			return around[0][c][TILE_SIZE + r];
+		if (r >= TILE_SIZE)
+			return around[2][c][r - TILE_SIZE];
+		return around[1][c][r];
+	};
+
+	// the tile framed like BitGrid rows of 3 words (west, tile, east), with the rows any neighbourhood reaches
+	// above and below it
+	const int REACH = 2;
+	const int FRAME_WORDS = 3;
+	uint64_t frame[(TILE_SIZE + 2 * REACH) * FRAME_WORDS];
+
+	for (int r = -REACH; r < TILE_SIZE + REACH; r++)
+		for (int c = 0; c < FRAME_WORDS; c++)
+			frame[(r + REACH) * FRAME_WORDS + c] = word(r, c);
+
+	for (int r = 0; r < TILE_SIZE; r++)
+		out->Rows[r] = Kernel::Step(rule, neighbourhood, frame + (r + REACH) * FRAME_WORDS, FRAME_WORDS, 1);
+}
+
+void SparseUniverse::NextGeneration(ThreadPool* pool)
+{
+	// candidates: every tile, and each neighbour one of its border cells can reach
+	int reach = LifeKernels::GetRule().GetReach();
+	uint64_t westBits = (1ULL << reach) - 1;
+	uint64_t eastBits = westBits << (TILE_SIZE - reach);
+
+	std::vector<uint64_t> candidates;
+	std::unordered_set<uint64_t> seen;
+	candidates.reserve(Tiles.size() * 2);
+
+	auto addCandidate = [&](int64_t tileRow, int64_t tileColumn) {
+		uint64_t key = Key(tileRow, tileColumn);
+		if (seen.insert(key).second)
+			candidates.push_back(key);
+	};
+
+	for (auto& iter : Tiles)
+	{
+		int64_t tileRow = KeyRow(iter.first), tileColumn = KeyColumn(iter.first);
+		const uint64_t* rows = iter.second->Rows;
+
+		// cells of the border rows and of any row, within reach of the edges
+		uint64_t top = 0, bottom = 0, columns = 0;
+		for (int r = 0; r < TILE_SIZE; r++)
+		{
+			if (r < reach)
+				top |= rows[r];
+			if (r >= TILE_SIZE - reach)
+				bottom |= rows[r];
+			columns |= rows[r];
+		}
+
+		addCandidate(tileRow, tileColumn);
+		if (top)									addCandidate(tileRow - 1, tileColumn);
+		if (bottom)									addCandidate(tileRow + 1, tileColumn);
+		if (columns & westBits)						addCandidate(tileRow, tileColumn - 1);
+		if (columns & eastBits)						addCandidate(tileRow, tileColumn + 1);
+		if (top & westBits)							addCandidate(tileRow - 1, tileColumn - 1);
+		if (top & eastBits)							addCandidate(tileRow - 1, tileColumn + 1);
+		if (bottom & westBits)						addCandidate(tileRow + 1, tileColumn - 1);
+		if (bottom & eastBits)						addCandidate(tileRow + 1, tileColumn + 1);
+	}
+
+	// step every candidate into a new tile, the old tiles are only read
+	std::vector<Tile*> next(candidates.size());
+	for (size_t i = 0; i < candidates.size(); i++)
+		next[i] = AllocateTile();
+
+	const int CHUNK = 64;
+	int chunks = (int)((candidates.size() + CHUNK - 1) / CHUNK);
+	auto stepChunk = [&](int chunk) {
+		size_t end = std::min(candidates.size(), (size_t)(chunk + 1) * CHUNK);
+		DispatchRule(LifeKernels::GetRule(), [&](const auto& rule, const auto& neighbourhood) {
+			for (size_t i = (size_t)chunk * CHUNK; i < end; i++)
+				StepTile(rule, neighbourhood, candidates[i], next[i]);
+		});
+	};
+
+	if (pool != nullptr)
+		pool->Run(chunks, stepChunk);
+	else
+		for (int chunk = 0; chunk < chunks; chunk++)
+			stepChunk(chunk);
+
+	// swap in the new tiles, dead ones go back to the free list
+	for (auto& iter : Tiles)
+		ReleaseTile(iter.second);
+	Tiles.clear();
+
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		bool empty = true;
+		for (int r = 0; r < TILE_SIZE && empty; r++)
+			empty = (next[i]->Rows[r] == 0);
+
+		if (empty)
+			ReleaseTile(next[i]);
+		else
+			Tiles.emplace(candidates[i], next[i]);
+	}
+
+	// keep at most one spare tile per live tile, so memory shrinks with the pattern
+	while (FreeTiles.size() > Tiles.size())
+	{
+		delete FreeTiles.back();
+		FreeTiles.pop_back();
+	}
+}
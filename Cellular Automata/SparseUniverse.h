@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "BitOps.h"
+
+class ThreadPool;
+
+/*
+
+	Unbounded board: the plane is cut in 64x64 tiles (one word per tile row, bit i = column i of the tile),
+	and only tiles holding living cells exist, in a hash map keyed by tile coordinate. Tiles are created
+	when the pattern grows into them and freed when they die, so memory follows the live pattern instead
+	of its bounding box.
+
+*/
+
+class SparseUniverse
+{
+public:
+	// constructor
+	SparseUniverse();
+	~SparseUniverse();
+
+	// kill every cell
+	void Clear();
+
+	// cell access, anywhere on the plane
+	bool Get(int64_t row, int64_t column) const;
+	void Set(int64_t row, int64_t column, bool alive);
+
+	// advance one generation under the rule of LifeKernels, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column) for every living cell in rows [rowBegin, rowEnd) x columns [columnBegin, columnEnd)
+	template <typename Func>
+	void ForEachLiveCell(int64_t rowBegin, int64_t rowEnd, int64_t columnBegin, int64_t columnEnd, Func func) const;
+
+	// call func(tileRow, tileColumn, rows) for every allocated tile
+	template <typename Func>
+	void ForEachTile(Func func) const;
+
+	size_t GetTileCount() const { return Tiles.size(); }
+
+	// tile access for bulk conversions, rows is TILE_SIZE words and an all-dead tile is freed
+	void SetTile(int64_t tileRow, int64_t tileColumn, const uint64_t* rows);
+
+	static const int TILE_SIZE = 64;
+
+private:
+	struct Tile
+	{
+		uint64_t Rows[TILE_SIZE];
+	};
+
+	std::unordered_map<uint64_t, Tile*> Tiles;
+	std::vector<Tile*> FreeTiles;
+
+	// tile keys
+	static uint64_t Key(int64_t tileRow, int64_t tileColumn);
+	static int64_t KeyRow(uint64_t key) { return (int32_t)(key >> 32); }
+	static int64_t KeyColumn(uint64_t key) { return (int32_t)(key & 0xFFFFFFFF); }
+
+	const Tile* FindTile(int64_t tileRow, int64_t tileColumn) const;
+	Tile* AllocateTile();
+	void ReleaseTile(Tile* tile);
+
+	template <typename Rule, typename Neighbourhood>
+	void StepTile(const Rule& rule, const Neighbourhood& neighbourhood, uint64_t key, Tile* out) const;
+};
+
+// floor(value / 64), also for negative values
+inline int64_t FloorDiv64(int64_t value)
+{
+	return (value >= 0) ? value / 64 : -((-value + 63) / 64);
+}
+
+template <typename Func>
+void SparseUniverse::ForEachLiveCell(int64_t rowBegin, int64_t rowEnd, int64_t columnBegin, int64_t columnEnd, Func func) const
+{
+	if (rowBegin >= rowEnd || columnBegin >= columnEnd)
+		return;
+
+	for (int64_t tileRow = FloorDiv64(rowBegin); tileRow <= FloorDiv64(rowEnd - 1); tileRow++)
+	{
+		for (int64_t tileColumn = FloorDiv64(columnBegin); tileColumn <= FloorDiv64(columnEnd - 1); tileColumn++)
+		{
+			const Tile* tile = FindTile(tileRow, tileColumn);
+			if (tile == nullptr)
+				continue;
+
+			for (int r = 0; r < TILE_SIZE; r++)
+			{
+				int64_t row = tileRow * TILE_SIZE + r;
+				if (row < rowBegin || row >= rowEnd)
+					continue;
+
+				uint64_t bits = tile->Rows[r];
+				while (bits)
+				{
+					int64_t column = tileColumn * TILE_SIZE + CountTrailingZeros(bits);
+					bits &= bits - 1;
+					if (columnBegin <= column && column < columnEnd)
+						func(row, column);
+				}
+			}
+		}
+	}
+}
+
+template <typename Func>
+void SparseUniverse::ForEachTile(Func func) const
+{
+	for (auto& iter : Tiles)
+		func(KeyRow(iter.first), KeyColumn(iter.first), (const uint64_t*)iter.second->Rows);
+}
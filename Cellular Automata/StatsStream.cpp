@@ -0,0 +1,122 @@
+#include "StatsStream.h"
+
+#include <chrono>
+#include <iostream>
+
+StatsStream::StatsStream()
+	: Format(STATS_CSV), Stopping(false), Dropped(0), Ring(CAPACITY)
+{
+	Head.Value = 0;
+	Tail.Value = 0;
+}
+
+StatsStream::~StatsStream()
+{
+	Close();
+}
+
+bool StatsStream::Open(const std::string& path, EStatsFormat format)
+{
+	Close();
+
+	File.open(path, std::ios::out | std::ios::trunc);
+	if (!File)
+	{
+		std::cout << "Could not create the statistics file \"" << path << "\"" << std::endl;
+		return false;
+	}
+
+	Format = format;
+	if (Format == STATS_CSV)
+		File << "generation,population,births,deaths,changed,top,left,bottom,right\n";
+	else
+		File << "[";
+
+	Head.Value = 0;
+	Tail.Value = 0;
+	Dropped = 0;
+	Stopping = false;
+	Writer = std::thread(&StatsStream::WriterLoop, this);
+	return true;
+}
+
+void StatsStream::Close()
+{
+	if (!Writer.joinable())
+		return;
+
+	Stopping = true;
+	Writer.join();
+
+	File << (Format == STATS_JSON ? "\n]\n" : "");
+	File.close();
+
+	if (Dropped > 0)
+		std::cout << "Statistics: " << Dropped << " generations dropped, the writer fell behind" << std::endl;
+}
+
+bool StatsStream::Push(const GenerationStats& stats)
+{
+	// only this thread writes Head, the writer only ever frees slots
+	uint64_t head = Head.Value.load(std::memory_order_relaxed);
+	if (head - Tail.Value.load(std::memory_order_acquire) >= (uint64_t)CAPACITY)
+	{
+		Dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Ring[head & (CAPACITY - 1)] = stats;
+	Head.Value.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void StatsStream::WriterLoop()
+{
+	uint64_t tail = Tail.Value.load(std::memory_order_relaxed);
+	while (true)
+	{
+		// read Stopping first: the records pushed before Close are all in head then
+		bool stopping = Stopping.load(std::memory_order_acquire);
+		uint64_t head = Head.Value.load(std::memory_order_acquire);
+
+		for (; tail < head; tail++)
+			Write(Ring[tail & (CAPACITY - 1)], tail == 0);
+		Tail.Value.store(tail, std::memory_order_release);
+
+		if (stopping)
+			break;
+
+		// nothing new: hand the file to the disk and wait for the next records
+		File.flush();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+void StatsStream::Write(const GenerationStats& stats, bool first)
+{
+	if (Format == STATS_CSV)
+	{
+		File << stats.Generation << ',' << stats.Population << ',' << stats.Births << ',' << stats.Deaths << ',' << stats.Births + stats.Deaths << ','
+			 << stats.Top << ',' << stats.Left << ',' << stats.Bottom << ',' << stats.Right << '\n';
+		return;
+	}
+
+	File << (first ? "\n" : ",\n") << "{\"generation\":" << stats.Generation << ",\"population\":" << stats.Population << ",\"births\":" << stats.Births
+		 << ",\"deaths\":" << stats.Deaths << ",\"changed\":" << stats.Births + stats.Deaths << ",\"box\":[" << stats.Top << ',' << stats.Left << ','
+		 << stats.Bottom << ',' << stats.Right << "]}";
+}
+
+static const char* FormatNames[] = { "csv", "json" };
+
+bool StatsStream::FindFormat(const std::string& name, EStatsFormat& format)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (name == FormatNames[i])
+		{
+			format = (EStatsFormat)i;
+			return true;
+		}
+	}
+	return false;
+}
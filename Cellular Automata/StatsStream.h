@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one generation of a board
+struct GenerationStats
+{
+	long long Generation;
+	long long Population, Births, Deaths;		// changed cells are Births + Deaths
+	int Top, Left, Bottom, Right;				// bounding box of the living cells, all -1 on a dead board
+};
+
+// what a stream is written as
+enum EStatsFormat
+{
+	STATS_CSV,					// a header line, then one line per generation
+	STATS_JSON					// an array of one object per generation
+};
+
+/*
+
+	Statistics of every generation, written to a file by a thread of its own so the simulation never waits for
+	the disk. The stepping thread pushes records into a ring of CAPACITY records and the writer thread drains
+	it: one producer and one consumer, each owning one index of the ring (a cache line each), so a push is a
+	copy and a release store, with neither a lock nor a wait. A push into a full ring (a writer that fell that
+	far behind) drops the record and counts it, instead of slowing the step down.
+
+	The records come from the step itself, see BitGrid::GetCounts and BitGrid::GetBoundingBox: the tiles count
+	their living cells, births and deaths with popcounts of the words they were stepped into.
+
+*/
+
+class StatsStream
+{
+public:
+	// constructor
+	StatsStream();
+	~StatsStream();
+
+	// start writing to path, false if it cannot be created
+	bool Open(const std::string& path, EStatsFormat format);
+
+	// write what is left in the ring, then stop the writer and close the file
+	void Close();
+
+	bool IsOpen() const { return Writer.joinable(); }
+
+	// stepping thread only: queue a record, false (and counted) if the ring is full
+	bool Push(const GenerationStats& stats);
+
+	long long GetDroppedCount() const { return Dropped.load(std::memory_order_relaxed); }
+
+	// formats by name ("csv", "json")
+	static bool FindFormat(const std::string& name, EStatsFormat& format);
+
+	// records the ring holds, a power of two
+	static const int CAPACITY = 1 << 14;
+
+private:
+	EStatsFormat Format;
+	std::ofstream File;
+	std::thread Writer;
+	std::atomic<bool> Stopping;
+	std::atomic<long long> Dropped;
+
+	std::vector<GenerationStats> Ring;
+
+	// records pushed (written by the stepping thread) and records written (by the writer thread), a cache line each
+	struct Index
+	{
+		std::atomic<uint64_t> Value;
+		char Padding[64 - sizeof(std::atomic<uint64_t>)];
+	};
+	Index Head, Tail;
+
+	void WriterLoop();
+	void Write(const GenerationStats& stats, bool first);
+};
@@ -0,0 +1,166 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount)
+	: Job(nullptr), StealingJob(nullptr), JobCount(0), NextJob(0), BusyWorkers(0), Batch(0), Stopping(false)
+{
+	if (threadCount <= 0)
+		threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+
+	Shares = std::vector<Share>(threadCount);
+	for (int i = 1; i < threadCount; i++)
+		Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Stopping = true;
+	}
+	WorkReady.notify_all();
+
+	for (std::thread& worker : Workers)
+		worker.join();
+}
+
+void ThreadPool::Run(int jobCount, const std::function<void(int)>& job)
+{
+	if (Workers.empty() || jobCount <= 1)
+	{
+		for (int i = 0; i < jobCount; i++)
+			job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Job = &job;
+		JobCount = jobCount;
+		NextJob = 0;
+		BusyWorkers = (int)Workers.size();
+		Batch++;
+	}
+	WorkReady.notify_all();
+
+	RunJobs(0);
+
+	// barrier: wait for the workers to finish their last job
+	std::unique_lock<std::mutex> lock(Mutex);
+	WorkDone.wait(lock, [this]() { return BusyWorkers == 0; });
+	Job = nullptr;
+}
+
+void ThreadPool::RunStealing(int jobCount, const std::function<void(int, int)>& job)
+{
+	if (Workers.empty() || jobCount <= 1)
+	{
+		for (int i = 0; i < jobCount; i++)
+			job(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		StealingJob = &job;
+		JobCount = jobCount;
+
+		// contiguous shares, so neighbouring jobs run on the same thread until someone steals
+		int threadCount = GetThreadCount();
+		for (int thread = 0; thread < threadCount; thread++)
+		{
+			uint64_t begin = (uint64_t)((long long)jobCount * thread / threadCount);
+			uint64_t end = (uint64_t)((long long)jobCount * (thread + 1) / threadCount);
+			Shares[thread].Range = begin | (end << 32);
+		}
+
+		BusyWorkers = (int)Workers.size();
+		Batch++;
+	}
+	WorkReady.notify_all();
+
+	RunJobs(0);
+
+	// barrier: wait for the workers to finish their last job
+	std::unique_lock<std::mutex> lock(Mutex);
+	WorkDone.wait(lock, [this]() { return BusyWorkers == 0; });
+	StealingJob = nullptr;
+}
+
+bool ThreadPool::TakeJob(int thread, int& index)
+{
+	// own share from the bottom
+	std::atomic<uint64_t>& own = Shares[thread].Range;
+	uint64_t range = own.load();
+	while ((uint32_t)range < (uint32_t)(range >> 32))
+	{
+		if (own.compare_exchange_weak(range, range + 1))
+		{
+			index = (int)(uint32_t)range;
+			return true;
+		}
+	}
+
+	// upper half of another share, its first job runs now and the rest becomes the own share; only this thread
+	// writes its own empty share, the others only swap non-empty ones
+	int threadCount = GetThreadCount();
+	for (int step = 1; step < threadCount; step++)
+	{
+		std::atomic<uint64_t>& victim = Shares[(thread + step) % threadCount].Range;
+		uint64_t stolen = victim.load();
+		while (true)
+		{
+			uint32_t begin = (uint32_t)stolen;
+			uint32_t end = (uint32_t)(stolen >> 32);
+			if (begin >= end)
+				break;
+
+			uint32_t middle = begin + (end - begin) / 2;
+			if (victim.compare_exchange_weak(stolen, begin | ((uint64_t)middle << 32)))
+			{
+				own = (uint64_t)(middle + 1) | ((uint64_t)end << 32);
+				index = (int)middle;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::RunJobs(int thread)
+{
+	if (StealingJob != nullptr)
+	{
+		int index;
+		while (TakeJob(thread, index))
+			(*StealingJob)(index, thread);
+		return;
+	}
+
+	for (int index = NextJob++; index < JobCount; index = NextJob++)
+		(*Job)(index);
+}
+
+void ThreadPool::WorkerLoop(int thread)
+{
+	unsigned int lastBatch = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			WorkReady.wait(lock, [&]() { return Stopping || Batch != lastBatch; });
+			if (Stopping)
+				return;
+			lastBatch = Batch;
+		}
+
+		RunJobs(thread);
+
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (--BusyWorkers == 0)
+			WorkDone.notify_one();
+	}
+}
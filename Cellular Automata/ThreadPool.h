@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+
+	Persistent worker threads. Run hands out job indices to the workers and to the calling thread and
+	returns only once every job has finished, so each call is a barrier.
+
+	RunStealing is for batches of uneven jobs (soups that die at once next to soups that run for thousands of
+	generations): every thread starts on its own contiguous share of the indices and, once that runs out,
+	steals the upper half of what is left of another thread's share. A share is a single atomic word holding
+	its [begin, end) range, taking a job or stealing is one compare-and-swap on it.
+
+*/
+
+class ThreadPool
+{
+public:
+	// constructor, threadCount counts the calling thread too (0 = one per hardware thread)
+	ThreadPool(int threadCount);
+	~ThreadPool();
+
+	// run job(index) for every index in [0, jobCount)
+	void Run(int jobCount, const std::function<void(int)>& job);
+
+	// run job(index, thread) for every index in [0, jobCount) with work stealing, thread in [0, GetThreadCount())
+	// being the thread running it (0 = the calling thread), for scratch state owned by each thread
+	void RunStealing(int jobCount, const std::function<void(int, int)>& job);
+
+	int GetThreadCount() const { return (int)Workers.size() + 1; }
+
+private:
+	std::vector<std::thread> Workers;
+
+	// current batch
+	std::mutex Mutex;
+	std::condition_variable WorkReady, WorkDone;
+	const std::function<void(int)>* Job;
+	const std::function<void(int, int)>* StealingJob;
+	int JobCount;
+	std::atomic<int> NextJob;
+
+	// share of every thread in a stealing batch, begin in the low and end in the high 32 bits, a cache line each
+	struct Share
+	{
+		std::atomic<uint64_t> Range;
+		char Padding[64 - sizeof(std::atomic<uint64_t>)];
+	};
+	std::vector<Share> Shares;
+	int BusyWorkers;
+	unsigned int Batch;
+	bool Stopping;
+
+	void WorkerLoop(int thread);
+	void RunJobs(int thread);
+
+	// take the next job of thread's share, or steal from another share, false once every share looked empty
+	bool TakeJob(int thread, int& index);
+};
@@ -0,0 +1,252 @@
+#include "VoxelGrid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// sum = a + b, bit-plane by bit-plane, sum has max(A, B) + 1 planes
+template <int A, int B>
+static inline void AddSliced(const uint64_t* a, const uint64_t* b, uint64_t* sum)
+{
+	const int BITS = (A > B) ? A : B;
+
+	uint64_t carry = 0;
+	for (int bit = 0; bit < BITS; bit++)
+	{
+		uint64_t x = (bit < A) ? a[bit] : 0;
+		uint64_t y = (bit < B) ? b[bit] : 0;
+		sum[bit] = x ^ y ^ carry;
+		carry = (x & y) | (carry & (x ^ y));
+	}
+	sum[BITS] = carry;
+}
+
+VoxelGrid::VoxelGrid()
+	: Width(0), Height(0), Depth(0), WordsPerRow(0), LastWordMask(~0ULL), Current(0)
+{
+
+}
+
+void VoxelGrid::Resize(int width, int height, int depth)
+{
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	Depth = std::max(depth, 1);
+	WordsPerRow = (Width + 63) / 64;
+	LastWordMask = (Width & 63) ? (1ULL << (Width & 63)) - 1 : ~0ULL;
+
+	size_t words = (size_t)Depth * Height * WordsPerRow;
+	Boards[0].assign(words, 0);
+	Boards[1].assign(words, 0);
+	Current = 0;
+}
+
+void VoxelGrid::Clear()
+{
+	std::fill(Boards[0].begin(), Boards[0].end(), 0);
+	std::fill(Boards[1].begin(), Boards[1].end(), 0);
+}
+
+void VoxelGrid::Set(int slice, int row, int column, bool alive)
+{
+	uint64_t& word = Row(Current, slice, row)[column >> 6];
+	uint64_t bit = 1ULL << (column & 63);
+	word = alive ? (word | bit) : (word & ~bit);
+}
+
+long long VoxelGrid::GetPopulation() const
+{
+	long long population = 0;
+	for (uint64_t word : Boards[Current])
+		population += PopCount(word);
+	return population;
+}
+
+void VoxelGrid::NextGeneration(ThreadPool* pool)
+{
+	auto addTest = [](std::vector<uint64_t>& tests, int value) {
+		for (int bit = 0; bit < COUNT_BITS; bit++)
+			tests.push_back(((value >> bit) & 1) ? ~0ULL : 0);
+	};
+
+	BirthTests.clear();
+	SurvivalTests.clear();
+	for (int count = 0; count <= Rule.GetNeighbourCount(); count++)
+	{
+		if ((Rule.Birth >> count) & 1)
+			addTest(BirthTests, count);
+		if ((Rule.Survival >> count) & 1)
+			addTest(SurvivalTests, Rule.VonNeumann ? count : count + 1);
+	}
+
+	int slabCount = (Depth + SLAB_SLICES - 1) / SLAB_SLICES;
+
+	// slabs only write their own slices of the other board
+	auto stepSlab = [&](int slab) {
+		int sliceBegin = slab * SLAB_SLICES;
+		int sliceEnd = std::min(sliceBegin + SLAB_SLICES, Depth);
+		if (Rule.VonNeumann)
+			StepSlabVonNeumann(sliceBegin, sliceEnd);
+		else
+			StepSlabMoore(sliceBegin, sliceEnd);
+	};
+
+	if (pool == nullptr || pool->GetThreadCount() == 1 || slabCount <= 1)
+	{
+		for (int slab = 0; slab < slabCount; slab++)
+			stepSlab(slab);
+	}
+	else
+	{
+		pool->Run(slabCount, stepSlab);
+	}
+
+	Current ^= 1;
+}
+
+template <int BITS>
+inline uint64_t VoxelGrid::ApplyRule(const uint64_t* count, uint64_t center) const
+{
+	uint64_t planes[BITS];
+	for (int bit = 0; bit < BITS; bit++)
+		planes[bit] = count[bit];
+
+	auto matchAny = [&planes](const std::vector<uint64_t>& tests) {
+		uint64_t match = 0;
+		for (size_t test = 0; test < tests.size(); test += COUNT_BITS)
+		{
+			uint64_t equal = ~0ULL;
+			for (int bit = 0; bit < BITS; bit++)
+				equal &= ~(planes[bit] ^ tests[test + bit]);
+			match |= equal;
+		}
+		return match;
+	};
+
+	return (center & matchAny(SurvivalTests)) | (~center & matchAny(BirthTests));
+}
+
+// sums[4 * (row * WordsPerRow + w) + bit], rowSums is scratch of 2 planes per word
+void VoxelGrid::SliceSums(int slice, uint64_t* sums, uint64_t* rowSums) const
+{
+	size_t planeWords = (size_t)Height * WordsPerRow;
+	if (slice < 0 || slice >= Depth)
+	{
+		std::fill(sums, sums + 4 * planeWords, 0);
+		return;
+	}
+
+	// left + center + right of every voxel
+	for (int row = 0; row < Height; row++)
+	{
+		const uint64_t* words = Row(Current, slice, row);
+		uint64_t* out = rowSums + 2 * (size_t)row * WordsPerRow;
+
+		for (int w = 0; w < WordsPerRow; w++)
+		{
+			uint64_t center = words[w];
+			uint64_t left = (center << 1) | ((w > 0) ? words[w - 1] >> 63 : 0);
+			uint64_t right = (center >> 1) | ((w + 1 < WordsPerRow) ? words[w + 1] << 63 : 0);
+
+			out[2 * w] = left ^ center ^ right;
+			out[2 * w + 1] = (left & center) | (right & (left ^ center));
+		}
+	}
+
+	// the row sums above, on and below every row
+	const uint64_t zero[2] = { 0, 0 };
+	for (int row = 0; row < Height; row++)
+	{
+		for (int w = 0; w < WordsPerRow; w++)
+		{
+			size_t index = (size_t)row * WordsPerRow + w;
+			const uint64_t* above = (row > 0) ? rowSums + 2 * (index - WordsPerRow) : zero;
+			const uint64_t* below = (row + 1 < Height) ? rowSums + 2 * (index + WordsPerRow) : zero;
+
+			uint64_t pair[3];
+			AddSliced<2, 2>(above, rowSums + 2 * index, pair);
+			AddSliced<3, 2>(pair, below, sums + 4 * index);
+		}
+	}
+}
+
+void VoxelGrid::StepSlabMoore(int sliceBegin, int sliceEnd)
+{
+	size_t planeWords = (size_t)Height * WordsPerRow;
+
+	// slice sums of slices s - 1, s and s + 1 in ring[(s + 1) % 3]
+	std::vector<uint64_t> ring(3 * 4 * planeWords), rowSums(2 * planeWords);
+	auto sumsOf = [&](int slice) { return &ring[(size_t)((slice + 1) % 3) * 4 * planeWords]; };
+
+	SliceSums(sliceBegin - 1, sumsOf(sliceBegin - 1), rowSums.data());
+	SliceSums(sliceBegin, sumsOf(sliceBegin), rowSums.data());
+
+	for (int slice = sliceBegin; slice < sliceEnd; slice++)
+	{
+		SliceSums(slice + 1, sumsOf(slice + 1), rowSums.data());
+
+		const uint64_t* front = sumsOf(slice - 1);
+		const uint64_t* here = sumsOf(slice);
+		const uint64_t* back = sumsOf(slice + 1);
+
+		for (int row = 0; row < Height; row++)
+		{
+			const uint64_t* cells = Row(Current, slice, row);
+			uint64_t* out = Row(Current ^ 1, slice, row);
+
+			for (int w = 0; w < WordsPerRow; w++)
+			{
+				size_t index = 4 * ((size_t)row * WordsPerRow + w);
+
+				// 3x3x3 count, 0..27 in 5 planes (the sixth is always 0)
+				uint64_t pair[5], count[6];
+				AddSliced<4, 4>(front + index, here + index, pair);
+				AddSliced<5, 4>(pair, back + index, count);
+
+				out[w] = ApplyRule<5>(count, cells[w]);
+			}
+			out[WordsPerRow - 1] &= LastWordMask;
+		}
+	}
+}
+
+void VoxelGrid::StepSlabVonNeumann(int sliceBegin, int sliceEnd)
+{
+	for (int slice = sliceBegin; slice < sliceEnd; slice++)
+	{
+		for (int row = 0; row < Height; row++)
+		{
+			const uint64_t* cells = Row(Current, slice, row);
+			const uint64_t* above = (row > 0) ? Row(Current, slice, row - 1) : nullptr;
+			const uint64_t* below = (row + 1 < Height) ? Row(Current, slice, row + 1) : nullptr;
+			const uint64_t* front = (slice > 0) ? Row(Current, slice - 1, row) : nullptr;
+			const uint64_t* back = (slice + 1 < Depth) ? Row(Current, slice + 1, row) : nullptr;
+			uint64_t* out = Row(Current ^ 1, slice, row);
+
+			for (int w = 0; w < WordsPerRow; w++)
+			{
+				uint64_t center = cells[w];
+				uint64_t left = (center << 1) | ((w > 0) ? cells[w - 1] >> 63 : 0);
+				uint64_t right = (center >> 1) | ((w + 1 < WordsPerRow) ? cells[w + 1] << 63 : 0);
+
+				// 0..6 in 3 planes
+				uint64_t count[3] = { 0, 0, 0 };
+				auto add = [&count](uint64_t neighbour) {
+					uint64_t carry = count[0] & neighbour;
+					count[0] ^= neighbour;
+					count[2] |= count[1] & carry;
+					count[1] ^= carry;
+				};
+
+				add(left);
+				add(right);
+				add(above ? above[w] : 0);
+				add(below ? below[w] : 0);
+				add(front ? front[w] : 0);
+				add(back ? back[w] : 0);
+
+				out[w] = ApplyRule<3>(count, center);
+			}
+			out[WordsPerRow - 1] &= LastWordMask;
+		}
+	}
+}
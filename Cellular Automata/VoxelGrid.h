@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BitOps.h"
+#include "LifeRule.h"
+
+class ThreadPool;
+
+/*
+
+	Board of a 3D Life-like rule (see VoxelRule): Depth slices of Height rows of Width voxels, every row packed
+	64 voxels to a word like a BitGrid row, so a voxel costs one bit and 512^3 voxels fit in 16 MB a board.
+	Voxels outside the board are dead.
+
+	A step runs in slabs of SLAB_SLICES slices on the thread pool. For the 26 voxel Moore neighbourhood every
+	slab rolls a ring of three bit-sliced slice sums, the living voxels of each 3x3 square of a slice (0..9, 4
+	bit-planes, built from the 3 voxel row sums of 3 rows), and adds the sums of the slices around each slice
+	into the 3x3x3 count (the voxel itself included, so a living voxel survives on its count + 1). Every slice
+	sum is built once per slab and used three times. The 6 voxel von Neumann neighbourhood is counted with one
+	bit-sliced increment per neighbour.
+
+*/
+
+class VoxelGrid
+{
+public:
+	// constructor
+	VoxelGrid();
+
+	// allocate a dead board of the given size
+	void Resize(int width, int height, int depth);
+
+	// kill every voxel
+	void Clear();
+
+	void SetRule(const VoxelRule& rule) { Rule = rule; }
+	const VoxelRule& GetRule() const { return Rule; }
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+	int GetDepth() const { return Depth; }
+
+	// voxel access
+	bool Get(int slice, int row, int column) const { return ((Row(Current, slice, row)[column >> 6] >> (column & 63)) & 1) != 0; }
+	void Set(int slice, int row, int column, bool alive);
+
+	// living voxels of the whole board
+	long long GetPopulation() const;
+
+	// advance one generation, spread over pool when one is given
+	void NextGeneration(ThreadPool* pool = nullptr);
+
+	// call func(row, column) for every living voxel of one slice, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(int slice, Func func) const;
+
+	// slices stepped by one job
+	static const int SLAB_SLICES = 8;
+
+private:
+	VoxelRule Rule;
+
+	int Width, Height, Depth;
+	int WordsPerRow;
+	uint64_t LastWordMask;
+
+	// current board and the one the next generation is written into
+	std::vector<uint64_t> Boards[2];
+	int Current;
+
+	// counts to test, every one as COUNT_BITS all-zero/all-one masks of its bits, filled from the rule before
+	// each step (the Moore count includes the voxel itself, so survival tests count + 1 there)
+	static const int COUNT_BITS = 5;
+	std::vector<uint64_t> BirthTests, SurvivalTests;
+
+	const uint64_t* Row(int board, int slice, int row) const { return &Boards[board][((size_t)slice * Height + row) * WordsPerRow]; }
+	uint64_t* Row(int board, int slice, int row) { return &Boards[board][((size_t)slice * Height + row) * WordsPerRow]; }
+
+	void StepSlabMoore(int sliceBegin, int sliceEnd);
+	void StepSlabVonNeumann(int sliceBegin, int sliceEnd);
+
+	// 4 bit-planes of the 3x3 sums of one slice of the current board, zero outside the board
+	void SliceSums(int slice, uint64_t* sums, uint64_t* rowSums) const;
+
+	// next state of 64 voxels from the BITS bit-planes of their count
+	template <int BITS>
+	uint64_t ApplyRule(const uint64_t* count, uint64_t center) const;
+};
+
+template <typename Func>
+void VoxelGrid::ForEachLiveCell(int slice, Func func) const
+{
+	for (int row = 0; row < Height; row++)
+	{
+		const uint64_t* words = Row(Current, slice, row);
+		for (int w = 0; w < WordsPerRow; w++)
+		{
+			uint64_t bits = words[w];
+			while (bits)
+			{
+				func(row, w * 64 + CountTrailingZeros(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#include "WireworldGrid.h"
+
+#include <algorithm>
+#include <cctype>
+
+WireworldGrid::WireworldGrid()
+	: Width(0), Height(0), Stride(2), ListsValid(true)
+{
+
+}
+
+void WireworldGrid::Resize(int width, int height)
+{
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	Stride = Width + 2;
+
+	Cells.assign((size_t)Stride * (Height + 2), WIRE_EMPTY);
+	HeadNeighbours.assign(Cells.size(), 0);
+	Clear();
+}
+
+void WireworldGrid::Clear()
+{
+	std::fill(Cells.begin(), Cells.end(), (uint8_t)WIRE_EMPTY);
+	Heads.clear();
+	Tails.clear();
+	Cooled.clear();
+	ListsValid = true;
+}
+
+void WireworldGrid::Set(int row, int column, EWireState state)
+{
+	uint8_t& cell = Cells[Index(row, column)];
+	if (cell == state)
+		return;
+
+	cell = state;
+	ListsValid = false;
+}
+
+int WireworldGrid::GetHeadCount()
+{
+	if (!ListsValid)
+		RebuildLists();
+
+	return (int)Heads.size();
+}
+
+void WireworldGrid::RebuildLists()
+{
+	Heads.clear();
+	Tails.clear();
+	Cooled.clear();
+
+	for (int index = 0; index < (int)Cells.size(); index++)
+	{
+		if (Cells[index] == WIRE_HEAD)
+			Heads.push_back(index);
+		else if (Cells[index] == WIRE_TAIL)
+			Tails.push_back(index);
+	}
+
+	ListsValid = true;
+}
+
+void WireworldGrid::NextGeneration()
+{
+	if (!ListsValid)
+		RebuildLists();
+
+	const int offsets[8] = { -Stride - 1, -Stride, -Stride + 1, -1, 1, Stride - 1, Stride, Stride + 1 };
+
+	// conductors next to a head, each listed once
+	Candidates.clear();
+	for (int head : Heads)
+	{
+		for (int offset : offsets)
+		{
+			int neighbour = head + offset;
+			if (Cells[neighbour] == WIRE_CONDUCTOR && HeadNeighbours[neighbour]++ == 0)
+				Candidates.push_back(neighbour);
+		}
+	}
+
+	NextHeads.clear();
+	for (int candidate : Candidates)
+	{
+		if (HeadNeighbours[candidate] <= 2)
+			NextHeads.push_back(candidate);
+		HeadNeighbours[candidate] = 0;
+	}
+
+	for (int tail : Tails)
+		Cells[tail] = WIRE_CONDUCTOR;
+	for (int head : Heads)
+		Cells[head] = WIRE_TAIL;
+	for (int head : NextHeads)
+		Cells[head] = WIRE_HEAD;
+
+	// tails -> cooled, heads -> tails, new heads -> heads
+	Cooled.swap(Tails);
+	Tails.swap(Heads);
+	Heads.swap(NextHeads);
+}
+
+bool WireworldGrid::IsRuleName(const std::string& text)
+{
+	std::string lower;
+	for (char c : text)
+		if (!std::isspace((unsigned char)c))
+			lower += (char)std::tolower((unsigned char)c);
+
+	return lower == "wireworld";
+}
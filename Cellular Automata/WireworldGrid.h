@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+
+	Board of Wireworld: empty cells never change, a head becomes a tail, a tail becomes a conductor and a
+	conductor becomes a head when one or two of its 8 neighbours are heads.
+
+	Circuits are mostly idle copper, so the board is never scanned. The cells currently holding heads and tails
+	are kept in lists: a step walks the heads, counts them into their conductor neighbours (the only cells
+	that can become heads) and rewrites the cells of the three lists, in work proportional to the number of
+	electrons whatever the size of the board. The board has a one-cell empty border so neighbours need no
+	bounds checks.
+
+*/
+
+enum EWireState : uint8_t
+{
+	WIRE_EMPTY,
+	WIRE_CONDUCTOR,
+	WIRE_HEAD,
+	WIRE_TAIL,
+	WIRE_STATE_COUNT
+};
+
+class WireworldGrid
+{
+public:
+	// constructor
+	WireworldGrid();
+
+	// allocate an empty board of the given size
+	void Resize(int width, int height);
+
+	// empty every cell
+	void Clear();
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+
+	// cell access, editing a cell makes the next step rebuild the head and tail lists
+	EWireState Get(int row, int column) const { return (EWireState)Cells[Index(row, column)]; }
+	void Set(int row, int column, EWireState state);
+
+	// advance one generation
+	void NextGeneration();
+
+	// number of electron heads
+	int GetHeadCount();
+
+	// call func(row, column, state) for every cell that is not empty, in row-major order
+	template <typename Func>
+	void ForEachLiveCell(Func func) const;
+
+	// call func(row, column, state) for every cell the last NextGeneration changed
+	template <typename Func>
+	void ForEachChangedCell(Func func) const;
+
+	// "wireworld", in any case
+	static bool IsRuleName(const std::string& text);
+
+private:
+	int Width, Height;
+
+	// (Height + 2) x (Width + 2) cells, the border stays empty
+	int Stride;
+	std::vector<uint8_t> Cells;
+
+	// heads around every conductor, only nonzero during a step
+	std::vector<uint8_t> HeadNeighbours;
+
+	// cell indices: heads, tails, tails turned back into conductors by the last step, and step scratch
+	std::vector<int> Heads, Tails, Cooled;
+	std::vector<int> Candidates, NextHeads;
+	bool ListsValid;
+
+	int Index(int row, int column) const { return (row + 1) * Stride + column + 1; }
+
+	// scan the board for heads and tails after an edit
+	void RebuildLists();
+
+	template <typename Func>
+	void ForEachIndex(const std::vector<int>& cells, Func func) const;
+};
+
+template <typename Func>
+void WireworldGrid::ForEachLiveCell(Func func) const
+{
+	for (int row = 0; row < Height; row++)
+	{
+		const uint8_t* cells = &Cells[Index(row, 0)];
+		for (int column = 0; column < Width; column++)
+			if (cells[column] != WIRE_EMPTY)
+				func(row, column, (int)cells[column]);
+	}
+}
+
+template <typename Func>
+void WireworldGrid::ForEachChangedCell(Func func) const
+{
+	ForEachIndex(Cooled, func);
+	ForEachIndex(Tails, func);
+	ForEachIndex(Heads, func);
+}
+
+template <typename Func>
+void WireworldGrid::ForEachIndex(const std::vector<int>& cells, Func func) const
+{
+	for (int index : cells)
+		func(index / Stride - 1, index % Stride - 1, (int)Cells[index]);
+}
@@ -5,6 +5,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <vector>
 
@@ -12,6 +14,23 @@
 #include "Animation.h"
 #include "TextRenderer.h"
 #include "Button.h"
+#include "BitGrid.h"
+#include "DoubleBuffer.h"
+#include "GenerationsGrid.h"
+#include "LargerThanLifeGrid.h"
+#include "LeniaGrid.h"
+#include "WireworldGrid.h"
+#include "ElementaryGrid.h"
+#include "VoxelGrid.h"
+#include "EnsembleGrid.h"
+#include "SoupSearch.h"
+#include "CycleDetector.h"
+#include "StatsStream.h"
+#include "LifeKernels.h"
+#include "Options.h"
+#include "ThreadPool.h"
+#include "HashLife.h"
+#include "SparseUniverse.h"
 
 // callback
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -26,6 +45,17 @@ void DrawTable();
 void DrawInterface(GLFWwindow* window);
 void processInput(GLFWwindow* window);
 void ProcessNextGeneration();
+void HashLifeJump();
+void FastForward();
+void RestartCycleDetection();
+void DetectCycle();
+void RecordStats();
+void RunEnsemble(int boardCount);
+void RunSoupSearch(int soupCount);
+void RefreshAnimations();
+void SetCell(int row, int column, bool alive);
+void GetVisibleCells(int& rowBegin, int& rowEnd, int& columnBegin, int& columnEnd);
+void SyncVisibleCells();
 
 // window settings
 const unsigned int SCR_WIDTH = 1200;
@@ -62,6 +92,7 @@ float TableUpY = 0;
 bool IsLeftMousePressed;
 bool IsRightMousePressed;
 bool IsLeftCtrlPressed;
+bool IsLeftShiftPressed;
 double LastX, LastY;
 
 // animation manager
@@ -83,10 +114,188 @@ bool TableHeightSelected;
 Button* BeginButton;
 
 // game of life
-std::vector<std::vector<bool>> TableMatrix, AuxTable;
+DoubleBuffer<BitGrid> TableMatrix;
+ThreadPool* StepWorkers;
 
-int main()
+// engine stepping the board, picked by the rule: Generations, Larger than Life, Lenia, Wireworld, elementary and
+// 3D rules have their own (bounded) boards, Life-like rules use TableMatrix or the unbounded board, Margolus rules
+// step the 2x2 blocks of TableMatrix
+enum EEngine
 {
+	ENGINE_LIFE,
+	ENGINE_GENERATIONS,
+	ENGINE_LARGER_THAN_LIFE,
+	ENGINE_LENIA,
+	ENGINE_WIREWORLD,
+	ENGINE_ELEMENTARY,
+	ENGINE_VOXEL,
+	ENGINE_MARGOLUS
+} Engine;
+
+std::string RuleName;
+GenerationsGrid GenerationsTable;
+LargerThanLifeGrid LargerTable;
+LeniaGrid LeniaTable;
+WireworldGrid WireTable;
+ElementaryGrid ElementaryTable;
+VoxelGrid VoxelTable;
+MargolusRule BlockRule;
+
+// 3D boards are drawn one slice at a time, VoxelDepth slices deep
+int VoxelDepth;
+int VoxelSlice = 0;
+
+// shades of gray a Lenia cell is drawn with, through the fading state colors
+const int LENIA_SHADES = 15;
+
+// unbounded board: only tiles with living cells are allocated, the view pans/zooms over the whole plane
+bool UnboundedTable = false;
+SparseUniverse* InfiniteTable;
+
+// hashlife jumps advance 2^HashLifeStep generations
+HashLife* Universe;
+int HashLifeStep;
+
+// generations the bounded Life board advances per pass over memory (and per frame), see BitGrid::NextGenerations
+int TimeBlock;
+
+// loops of the Life-like boards, see CycleDetector: LifeGeneration counts the generations since the board was
+// last drawn (its parity is where the blocks of a Margolus rule start), and the first loop found is reported (and
+// pauses the board with --on-cycle=pause)
+CycleDetector LifeCycle;
+long long LifeGeneration = 0;
+bool PauseOnCycle;
+
+// population, births, deaths and bounding box of every generation of the bounded Life (or Margolus) board, written
+// to the file of --stats by a thread of its own, see StatsStream
+StatsStream LifeStats;
+
+int main(int argc, char* argv[])
+{
+	// command line: --kernel=scalar|sse2|avx2|avx512 (or CA_KERNEL), --threads=N (or CA_THREADS, 0 = all cores),
+	//				 --hashlife-step=N (or CA_HASHLIFE_STEP), --rule=B3/S23 (or CA_RULE), --topology=dead|torus|klein|mirror
+	//				 (or CA_TOPOLOGY), --depth=N (or CA_DEPTH, slices of a 3D board), --time-block=N (or CA_TIME_BLOCK),
+	//				 --ensemble=N (or CA_ENSEMBLE, N random soups without a window, see RunEnsemble), --soups=N (or CA_SOUPS,
+	//				 census of N random soups without a window, see RunSoupSearch), --on-cycle=report|pause (or CA_ON_CYCLE),
+	//				 --stats=file (or CA_STATS), --stats-format=csv|json (or CA_STATS_FORMAT)
+	Options::Parse(argc, argv);
+	LifeKernels::Init(Options::Get("kernel"));
+
+	std::string RuleText = Options::Get("rule");
+	LargerThanLifeRule LargerRule;
+	LeniaRule ContinuousRule;
+	ElementaryRule RowRule;
+	VoxelRule SpaceRule;
+	if (LargerThanLifeRule::Parse(RuleText, LargerRule))
+	{
+		Engine = ENGINE_LARGER_THAN_LIFE;
+		LargerTable.SetRule(LargerRule);
+		RuleName = LargerRule.ToString();
+	}
+	else if (LeniaRule::Parse(RuleText, ContinuousRule))
+	{
+		Engine = ENGINE_LENIA;
+		LeniaTable.SetRule(ContinuousRule);
+		RuleName = ContinuousRule.ToString();
+	}
+	else if (WireworldGrid::IsRuleName(RuleText))
+	{
+		Engine = ENGINE_WIREWORLD;
+		RuleName = "wireworld";
+	}
+	else if (ElementaryRule::Parse(RuleText, RowRule))
+	{
+		Engine = ENGINE_ELEMENTARY;
+		ElementaryTable.SetRule(RowRule);
+		RuleName = RowRule.ToString();
+	}
+	else if (VoxelRule::Parse(RuleText, SpaceRule))
+	{
+		Engine = ENGINE_VOXEL;
+		VoxelTable.SetRule(SpaceRule);
+		RuleName = SpaceRule.ToString();
+	}
+	else if (MargolusRule::Parse(RuleText, BlockRule))
+	{
+		Engine = ENGINE_MARGOLUS;
+		RuleName = BlockRule.ToString();
+		if (!BlockRule.IsReversible())
+			std::cout << "The table of " << RuleName << " is not a permutation, the rule is not reversible" << std::endl;
+	}
+	else
+	{
+		GenerationsRule Rule;
+		if (!RuleText.empty() && !GenerationsRule::Parse(RuleText, Rule))
+			std::cout << "Unknown rule \"" << RuleText << "\", using " << Rule.ToString() << std::endl;
+
+		Engine = (Rule.States > 2) ? ENGINE_GENERATIONS : ENGINE_LIFE;
+		LifeKernels::SetRule(Rule.Life);
+		GenerationsTable.SetStateCount(Rule.States);
+		RuleName = Rule.ToString();
+	}
+	std::cout << "Rule: " << RuleName << std::endl;
+
+	// edges of the bounded Life board, kept when the board is resized
+	ETopology Topology = TOPOLOGY_DEAD;
+	std::string TopologyText = Options::Get("topology");
+	if (!TopologyText.empty() && !BitGrid::FindTopology(TopologyText, Topology))
+		std::cout << "Unknown topology \"" << TopologyText << "\", using " << BitGrid::GetTopologyName(Topology) << std::endl;
+	TableMatrix.Front().SetTopology(Topology);
+	ElementaryTable.SetWrapped(Topology == TOPOLOGY_TORUS);
+
+	// --benchmark=N: time N generations of every kernel on the table size, then exit
+	int BenchmarkGenerations = Options::GetInt("benchmark", 0);
+	if (BenchmarkGenerations > 0)
+	{
+		LifeKernels::Benchmark(Options::GetInt("benchmark-width", 4096), Options::GetInt("benchmark-height", 4096), BenchmarkGenerations, Options::GetInt("time-block", 8));
+		return 0;
+	}
+
+	// --self-test: check every kernel steps tiles left to the back board right, then exit (1 on a failure)
+	if (Options::GetInt("self-test", 0) > 0)
+		return LifeKernels::SelfTest() ? 0 : 1;
+
+	StepWorkers = new ThreadPool(Options::GetInt("threads", 0));
+
+	// --ensemble=N: run N small random soups of the rule side by side until they settle, then exit
+	int EnsembleBoards = Options::GetInt("ensemble", 0);
+	if (EnsembleBoards > 0)
+	{
+		RunEnsemble(EnsembleBoards);
+		delete StepWorkers;
+		return 0;
+	}
+
+	// --soups=N: search N random soups of the rule for the objects they leave, then exit
+	int SoupCount = Options::GetInt("soups", 0);
+	if (SoupCount > 0)
+	{
+		RunSoupSearch(SoupCount);
+		delete StepWorkers;
+		return 0;
+	}
+
+	InfiniteTable = new SparseUniverse();
+	Universe = new HashLife();
+	HashLifeStep = std::min(std::max(Options::GetInt("hashlife-step", 10), 0), 60);
+	VoxelDepth = std::min(std::max(Options::GetInt("depth", 64), 1), 4096);
+	TimeBlock = std::min(std::max(Options::GetInt("time-block", 1), 1), 64);
+
+	std::string CycleText = Options::Get("on-cycle");
+	if (!CycleText.empty() && CycleText != "report" && CycleText != "pause")
+		std::cout << "Unknown --on-cycle \"" << CycleText << "\", using report" << std::endl;
+	PauseOnCycle = (CycleText == "pause");
+
+	std::string StatsPath = Options::Get("stats");
+	if (!StatsPath.empty())
+	{
+		EStatsFormat StatsFormat = STATS_CSV;
+		std::string FormatText = Options::Get("stats-format");
+		if (!FormatText.empty() && !StatsStream::FindFormat(FormatText, StatsFormat))
+			std::cout << "Unknown --stats-format \"" << FormatText << "\", using csv" << std::endl;
+		LifeStats.Open(StatsPath, StatsFormat);
+	}
+
 	// glfw: initialize and configure
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -131,6 +340,8 @@ int main()
 	TableState = ETableState::TABLE_INPUT;
 
 	Animations = new AnimationManager((float)SquareSize, (int)TableUpX, (int)TableUpY);
+	Animations->SetStateCount(Engine == ENGINE_LENIA ? LENIA_SHADES + 1 : GenerationsTable.GetStateCount());
+	Animations->SetPalette(Engine == ENGINE_WIREWORLD ? PALETTE_WIREWORLD : PALETTE_FADING);
 	RenderText = new TextRenderer(SCR_WIDTH, SCR_HEIGHT);
 	BeginButton = new Button(glm::vec2(SCR_WIDTH / 2.0f - 80.0f, SCR_HEIGHT / 2.0f - 80.0f), glm::vec2(150.0f, 50.0f), glm::vec3(0.5f, 0.5f, 0.5f), "Begin");
 
@@ -185,6 +396,10 @@ int main()
 	delete Animations;
 	delete RenderText;
 	delete BeginButton;
+	delete StepWorkers;
+	delete InfiniteTable;
+	delete Universe;
+	LifeStats.Close();
 
 	// glfw: terminate, clearing all previously allocated GLFW resources
 	glfwTerminate();
@@ -207,6 +422,15 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 	if (TableState == ETableState::TABLE_INPUT)
 	{
+		if (key == GLFW_KEY_U && action == GLFW_PRESS && Engine == ENGINE_LIFE)
+			UnboundedTable = !UnboundedTable;
+
+		if (key == GLFW_KEY_T && action == GLFW_PRESS && (Engine == ENGINE_LIFE || Engine == ENGINE_MARGOLUS))
+			TableMatrix.Front().SetTopology((ETopology)((TableMatrix.Front().GetTopology() + 1) % TOPOLOGY_COUNT));
+
+		if (key == GLFW_KEY_T && action == GLFW_PRESS && Engine == ENGINE_ELEMENTARY)
+			ElementaryTable.SetWrapped(!ElementaryTable.IsWrapped());
+
 		if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS)
 		{
 			if (TableWidthSelected)
@@ -238,20 +462,37 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 			TableState = ETableState::TABLE_DRAW;
 			TimerAnimation = 0.0f;
 			Animations->Reset();
-			TableMatrix.assign(TABLE_HEIGHT, std::vector<bool>(TABLE_WIDTH, false));
-			AuxTable.assign(TABLE_HEIGHT, std::vector<bool>(TABLE_WIDTH, false));
+			TableMatrix.Clear();
+			InfiniteTable->Clear();
+			GenerationsTable.Clear();
+			LargerTable.Clear();
+			LeniaTable.Clear();
+			WireTable.Clear();
+			ElementaryTable.Clear();
+			VoxelTable.Clear();
 		}
 
 		if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
 		{
 			if (TableState == ETableState::TABLE_DRAW)
+			{
+				// cells are only drawn before this, the generations count from here
 				TableState = ETableState::TABLE_PLAY;
+				LifeGeneration = 0;
+				RestartCycleDetection();
+			}
 			else if (TableState == ETableState::TABLE_PLAY)
 				TableState = ETableState::TABLE_PAUSE;
 			else if (TableState == ETableState::TABLE_PAUSE)
 				TableState = ETableState::TABLE_PLAY;
 		}
 
+		if (key == GLFW_KEY_H && action == GLFW_PRESS)
+			HashLifeJump();
+
+		if (key == GLFW_KEY_F && action == GLFW_PRESS)
+			FastForward();
+
 		if (key == GLFW_KEY_LEFT_CONTROL && action == GLFW_PRESS)
 		{
 			glfwGetCursorPos(window, &LastX, &LastY);
@@ -263,6 +504,21 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 			IsLeftCtrlPressed = false;
 			glfwSetCursor(window, NULL);
 		}
+
+		if (key == GLFW_KEY_LEFT_SHIFT && action == GLFW_PRESS)
+			IsLeftShiftPressed = true;
+		else if (key == GLFW_KEY_LEFT_SHIFT && action == GLFW_RELEASE)
+			IsLeftShiftPressed = false;
+
+		// slice of the 3D board on screen
+		if ((key == GLFW_KEY_UP || key == GLFW_KEY_DOWN) && action != GLFW_RELEASE && Engine == ENGINE_VOXEL)
+		{
+			VoxelSlice = std::min(std::max(VoxelSlice + (key == GLFW_KEY_UP ? 1 : -1), 0), VoxelTable.GetDepth() - 1);
+			std::cout << "Slice " << VoxelSlice << " / " << VoxelTable.GetDepth() << ", population " << VoxelTable.GetPopulation() << std::endl;
+
+			Animations->Reset();
+			RefreshAnimations();
+		}
 	}
 }
 
@@ -273,6 +529,27 @@ void processInput(GLFWwindow* window)
 		// Check if a square is selected
 		glfwGetCursorPos(window, &LastX, &LastY);
 
+		if (UnboundedTable)
+		{
+			if (LastX < 0 || LastX >= SCR_WIDTH || LastY < 0 || LastY >= SCR_HEIGHT)
+				return;
+
+			int SquareRow = (int)std::floor((LastY - TableUpY) / SquareSize);
+			int SquareColumn = (int)std::floor((LastX - TableUpX) / SquareSize);
+
+			if (IsRightMousePressed)
+			{
+				Animations->DeleteBlock({ SquareRow, SquareColumn });
+				InfiniteTable->Set(SquareRow, SquareColumn, false);
+			}
+			else if (IsLeftMousePressed)
+			{
+				Animations->AddBlock({ SquareRow, SquareColumn });
+				InfiniteTable->Set(SquareRow, SquareColumn, true);
+			}
+			return;
+		}
+
 		int TableDownX = (int)TableUpX + SquareSize * TABLE_WIDTH;
 		int TableDownY = (int)TableUpY + SquareSize * TABLE_HEIGHT;
 
@@ -284,12 +561,12 @@ void processInput(GLFWwindow* window)
 			if (IsRightMousePressed)
 			{
 				Animations->DeleteBlock({ SquareRow, SquareColumn });
-				TableMatrix[SquareRow][SquareColumn] = false;
+				SetCell(SquareRow, SquareColumn, false);
 			}
 			else if (IsLeftMousePressed)
 			{
 				Animations->AddBlock({ SquareRow, SquareColumn });
-				TableMatrix[SquareRow][SquareColumn] = true;
+				SetCell(SquareRow, SquareColumn, true);
 			}
 		}
 	}
@@ -314,6 +591,7 @@ void mouse_cursor_callback(GLFWwindow* window, double xpos, double ypos)
 			TableUpY -= (float)yoffset;
 
 			Animations->SetTablePosition((int)TableUpX, (int)TableUpY);
+			SyncVisibleCells();
 		}
 	}
 }
@@ -355,6 +633,7 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	TableUpY = (float)LastY - LastSquareY * (float)SquareSize;
 
 	Animations->SetTablePosition((int)TableUpX, (int)TableUpY);
+	SyncVisibleCells();
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
@@ -424,29 +703,45 @@ void DrawTable()
 {
 	glm::mat4 model = glm::mat4(1.0f);
 
+	// the lines crossing the screen, within the edges of the bounded board (the unbounded one has none)
+	int RowBegin, RowEnd, ColumnBegin, ColumnEnd;
+	GetVisibleCells(RowBegin, RowEnd, ColumnBegin, ColumnEnd);
+	if (!UnboundedTable)
+	{
+		RowBegin = std::max(RowBegin, 0);
+		RowEnd = std::min(RowEnd, TABLE_HEIGHT);
+		ColumnBegin = std::max(ColumnBegin, 0);
+		ColumnEnd = std::min(ColumnEnd, TABLE_WIDTH);
+		if (RowBegin >= RowEnd || ColumnBegin >= ColumnEnd)
+			return;
+	}
+
 	// draw rows and columns
 	glBindVertexArray(LineVAO);
 	ResourceManager::GetShader("line").Use();
 	ResourceManager::GetShader("line").SetVector3f("color", glm::vec3(0.0f, 0.0f, 0.0f));
 
+	int LeftX = (int)TableUpX + ColumnBegin * SquareSize;
+	int TopY = (int)TableUpY + RowBegin * SquareSize;
+
 	// draw rows
-	for (int y = (int)TableUpY; y <= (int)TableUpY + TABLE_HEIGHT * SquareSize; y += SquareSize)
+	for (int y = TopY; y <= (int)TableUpY + RowEnd * SquareSize; y += SquareSize)
 	{
 		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3((int)TableUpX, y, 0.0f));
-		model = glm::scale(model, glm::vec3((float)(TABLE_WIDTH * SquareSize), 0.0f, 0.0f));
+		model = glm::translate(model, glm::vec3(LeftX, y, 0.0f));
+		model = glm::scale(model, glm::vec3((float)((ColumnEnd - ColumnBegin) * SquareSize), 0.0f, 0.0f));
 		ResourceManager::GetShader("line").SetMatrix4f("model", model);
 
 		glDrawArrays(GL_LINES, 0, 2);
 	}
 
 	// draw columns
-	for (int x = (int)TableUpX; x <= (int)TableUpX + TABLE_WIDTH * SquareSize; x += SquareSize)
+	for (int x = LeftX; x <= (int)TableUpX + ColumnEnd * SquareSize; x += SquareSize)
 	{
 		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(x, (int)TableUpY, 0.0f));
+		model = glm::translate(model, glm::vec3(x, TopY, 0.0f));
 		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		model = glm::scale(model, glm::vec3((float)(TABLE_HEIGHT * SquareSize), 0.0f, 0.0f));
+		model = glm::scale(model, glm::vec3((float)((RowEnd - RowBegin) * SquareSize), 0.0f, 0.0f));
 		ResourceManager::GetShader("line").SetMatrix4f("model", model);
 
 		glDrawArrays(GL_LINES, 0, 2);
@@ -470,7 +765,11 @@ void DrawInterface(GLFWwindow* window)
 	BeginButton->Render(RenderText, glm::vec2(35.0f, 5.0f));
 
 	RenderText->Load("fonts/Antonio-Regular.ttf", 20);
-	RenderText->RenderText("Left Click = draw square", 20.0f, (float)SCR_HEIGHT - 200.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	RenderText->RenderText("Rule: " + RuleName, 20.0f, (float)SCR_HEIGHT - 320.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	RenderText->RenderText(std::string("T = edges of the bounded board: ") + (Engine == ENGINE_LENIA ? "torus" : Engine == ENGINE_ELEMENTARY ? (ElementaryTable.IsWrapped() ? "torus" : "dead") : Engine != ENGINE_LIFE && Engine != ENGINE_MARGOLUS ? "dead" : BitGrid::GetTopologyName(TableMatrix.Front().GetTopology())), 20.0f, (float)SCR_HEIGHT - 290.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	RenderText->RenderText(std::string("U = unbounded board: ") + (Engine != ENGINE_LIFE ? "only for Life-like rules" : (UnboundedTable ? "on" : "off")), 20.0f, (float)SCR_HEIGHT - 260.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	RenderText->RenderText("H = jump 2^" + std::to_string(HashLifeStep) + " generations", 20.0f, (float)SCR_HEIGHT - 230.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	RenderText->RenderText(Engine == ENGINE_WIREWORLD ? "Left Click = draw wire, with Left Shift = electron" : Engine == ENGINE_ELEMENTARY ? "Left Click = draw square of the current generation" : Engine == ENGINE_VOXEL ? "Left Click = draw voxel of the slice, Up/Down = change slice" : "Left Click = draw square", 20.0f, (float)SCR_HEIGHT - 200.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
 	RenderText->RenderText("Right Click = erase square", 20.0f, (float)SCR_HEIGHT - 170.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
 	RenderText->RenderText("Space = resume/pause game of life", 20.0f, (float)SCR_HEIGHT - 140.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
 	RenderText->RenderText("Left CTRL = move board", 20.0f, (float)SCR_HEIGHT - 110.0f, 1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
@@ -502,8 +801,23 @@ void DrawInterface(GLFWwindow* window)
 
 	if (BeginButton->IsClicked())
 	{
-		TableMatrix.assign(TABLE_HEIGHT, std::vector<bool>(TABLE_WIDTH, false));
-		AuxTable.assign(TABLE_HEIGHT, std::vector<bool>(TABLE_WIDTH, false));
+		if (Engine == ENGINE_GENERATIONS)
+			GenerationsTable.Resize(TABLE_WIDTH, TABLE_HEIGHT);
+		else if (Engine == ENGINE_LARGER_THAN_LIFE)
+			LargerTable.Resize(TABLE_WIDTH, TABLE_HEIGHT);
+		else if (Engine == ENGINE_LENIA)
+			LeniaTable.Resize(TABLE_WIDTH, TABLE_HEIGHT);
+		else if (Engine == ENGINE_WIREWORLD)
+			WireTable.Resize(TABLE_WIDTH, TABLE_HEIGHT);
+		else if (Engine == ENGINE_ELEMENTARY)
+			ElementaryTable.Resize(TABLE_WIDTH, TABLE_HEIGHT);
+		else if (Engine == ENGINE_VOXEL)
+		{
+			VoxelTable.Resize(TABLE_WIDTH, TABLE_HEIGHT, VoxelDepth);
+			VoxelSlice = VoxelDepth / 2;
+		}
+		else
+			TableMatrix.Resize(TABLE_WIDTH, TABLE_HEIGHT);
 		TableState = ETableState::TABLE_DRAW;
 	}
 }
@@ -514,6 +828,9 @@ void DrawInterface(GLFWwindow* window)
 
 /*
 
+	Default rule B3/S23, any other Bx/Sy rule, S/B/C Generations rule, Larger than Life rule, Lenia rule,
+	Wireworld, elementary, 3D or Margolus rule can be given with --rule:
+
 	1. Any live cell with fewer than two live neighbours dies, as if by underpopulation.
 	2. Any live cell with two or three live neighbours lives on to the next generation.
 	3. Any live cell with more than three live neighbours dies, as if by overpopulation.
@@ -521,47 +838,460 @@ void DrawInterface(GLFWwindow* window)
 
 */
 
-bool InMatrix(int x, int y)
+void ProcessNextGeneration()
+{
+	if (Engine == ENGINE_WIREWORLD)
+	{
+		// only the cells of the head and tail lists change, and so do only their squares: the copper is
+		// neither stepped nor redrawn
+		WireTable.NextGeneration();
+		WireTable.ForEachChangedCell([](int x, int y, int state) { Animations->AddBlock({ x, y }, state); });
+		return;
+	}
+
+	if (Engine == ENGINE_ELEMENTARY)
+	{
+		// one bit-packed row per generation, written on the line below the previous one: until the board
+		// is full only that line has new squares, then every line moves up
+		ElementaryTable.NextGeneration(StepWorkers);
+		if (ElementaryTable.GetGeneration() < ElementaryTable.GetHeight())
+		{
+			ElementaryTable.ForEachLiveCellInRow(ElementaryTable.GetCurrentRow(), [](int x, int y) { Animations->AddBlock({ x, y }); });
+			return;
+		}
+
+		Animations->Reset();
+		RefreshAnimations();
+		return;
+	}
+
+	Animations->Reset();
+
+	if (UnboundedTable)
+	{
+		// 64x64 tiles, only the ones holding or touching living cells are stepped
+		InfiniteTable->NextGeneration(StepWorkers);
+		LifeGeneration++;
+		DetectCycle();
+		RefreshAnimations();
+		return;
+	}
+
+	if (Engine == ENGINE_GENERATIONS)
+	{
+		// state bit-planes updated in place, band by band
+		GenerationsTable.NextGeneration(StepWorkers);
+		RefreshAnimations();
+		return;
+	}
+
+	if (Engine == ENGINE_LARGER_THAN_LIFE)
+	{
+		// sliding column sums, O(1) per cell whatever the radius
+		LargerTable.NextGeneration(StepWorkers);
+		RefreshAnimations();
+		return;
+	}
+
+	if (Engine == ENGINE_VOXEL)
+	{
+		// the whole volume is stepped, 64 voxels per word in slabs of slices on the worker threads; only the
+		// slice on screen is drawn
+		VoxelTable.NextGeneration(StepWorkers);
+		RefreshAnimations();
+		return;
+	}
+
+	if (Engine == ENGINE_LENIA)
+	{
+		// ring kernel convolved through real-to-complex FFTs, rows and columns on the worker threads
+		LeniaTable.NextGeneration(StepWorkers);
+		RefreshAnimations();
+		return;
+	}
+
+	if (Engine == ENGINE_MARGOLUS)
+	{
+		// the 2x2 blocks of the board through the rule table, 32 blocks per word on the widest SIMD kernel of the
+		// host, in tile rows on the worker threads; the blocks start one cell further every other generation
+		TableMatrix.StepBlocks(BlockRule, (LifeGeneration & 1) != 0, StepWorkers);
+		LifeGeneration++;
+		RecordStats();
+
+		RefreshAnimations();
+		return;
+	}
+
+	// 64 cells per word on the widest SIMD kernel of the host, see LifeKernels, in row bands on the worker threads,
+	// written into the back board which then becomes the front one; with --time-block several generations in one
+	// pass of cache-sized blocks
+	TableMatrix.Step(StepWorkers, TimeBlock);
+	LifeGeneration += TimeBlock;
+	DetectCycle();
+	RecordStats();
+
+	RefreshAnimations();
+}
+
+// forget the states seen, and record the board as it is now
+void RestartCycleDetection()
 {
-	return 0 <= x && x < TABLE_HEIGHT && 0 <= y && y < TABLE_WIDTH;
+	if (Engine != ENGINE_LIFE)
+		return;
+
+	// a shifted pattern evolves the same only where no edge is near
+	LifeCycle.Reset();
+	LifeCycle.SetTranslations(UnboundedTable || TableMatrix.Front().GetTopology() == TOPOLOGY_TORUS);
+	if (UnboundedTable)
+		LifeCycle.Update(*InfiniteTable, LifeGeneration);
+	else
+		LifeCycle.Update(TableMatrix.Front(), nullptr, LifeGeneration);
 }
 
-const int DirX[] = { 0, 0, 1, 1, 1, -1, -1, -1 };
-const int DirY[] = { -1, 1, -1, 0, 1, -1, 0, 1 };
+// hash the new generation from the cells that flipped (from scratch after a step of several generations, whose
+// back board holds no generation), and report the first state that comes back
+void DetectCycle()
+{
+	if (Engine != ENGINE_LIFE)
+		return;
+
+	bool known = LifeCycle.HasCycle();
+	bool repeated;
+	if (UnboundedTable)
+		repeated = LifeCycle.Update(*InfiniteTable, LifeGeneration);
+	else
+		repeated = LifeCycle.Update(TableMatrix.Front(), (TimeBlock == 1) ? &TableMatrix.Back() : nullptr, LifeGeneration);
 
-void ProcessNextGeneration()
+	if (!repeated || known)
+		return;
+
+	// with --time-block only every TimeBlock-th generation is seen, the period is then a multiple of the real one
+	std::cout << "Generation " << LifeGeneration << ": the board repeats generation " << LifeCycle.GetCycleStart() << ", period " << LifeCycle.GetPeriod();
+	if (LifeCycle.GetRowShift() != 0 || LifeCycle.GetColumnShift() != 0)
+		std::cout << ", moving " << LifeCycle.GetRowShift() << " rows and " << LifeCycle.GetColumnShift() << " columns per period";
+	std::cout << " (F to fast-forward)" << std::endl;
+
+	if (PauseOnCycle)
+		TableState = ETableState::TABLE_PAUSE;
+}
+
+// counted by the tiles during the step: nothing is read from the board but one record per tile
+void RecordStats()
 {
-	Animations->Reset();
+	if (!LifeStats.IsOpen() || (Engine != ENGINE_LIFE && Engine != ENGINE_MARGOLUS) || UnboundedTable)
+		return;
+
+	GenerationStats Stats;
+	Stats.Generation = LifeGeneration;
+	TableMatrix.Front().GetCounts(Stats.Population, Stats.Births, Stats.Deaths);
+	if (!TableMatrix.Front().GetBoundingBox(Stats.Top, Stats.Left, Stats.Bottom, Stats.Right))
+		Stats.Top = Stats.Left = Stats.Bottom = Stats.Right = -1;
+	LifeStats.Push(Stats);
+}
 
-	for (int x = 0; x < TABLE_HEIGHT; x++)
+// skip whole periods of the loop found, about 2^HashLifeStep generations like a HashLife jump: the board only
+// moves by the displacement of the loop
+void FastForward()
+{
+	if (Engine != ENGINE_LIFE || !LifeCycle.HasCycle())
 	{
-		for (int y = 0; y < TABLE_WIDTH; y++)
-		{
-			int LivingCells = 0;
-			for (int i = 0; i < 8; i++)
-			{
-				std::pair<int, int> neighbour = { x + DirX[i], y + DirY[i] };
-				if (InMatrix(neighbour.first, neighbour.second) && TableMatrix[neighbour.first][neighbour.second])
-					LivingCells++;
-			}
+		std::cout << "Fast-forward needs a board that repeats, none found yet" << std::endl;
+		return;
+	}
 
-			if (TableMatrix[x][y])
-			{
-				if (2 <= LivingCells && LivingCells <= 3)
-					AuxTable[x][y] = true;
-				else
-					AuxTable[x][y] = false;
-			}
-			else if (LivingCells == 3)
-			{
-				AuxTable[x][y] = true;
-			}
+	long long period = LifeCycle.GetPeriod();
+	long long loops = std::max((1LL << HashLifeStep) / period, 1LL);
+
+	// tiles of the unbounded board are addressed by 32-bit coordinates
+	int64_t stride = std::max(std::abs(LifeCycle.GetRowShift()), std::abs(LifeCycle.GetColumnShift()));
+	if (stride > 0)
+		loops = std::min(loops, std::max((1LL << 30) / stride, 1LL));
+
+	int64_t rowShift = loops * LifeCycle.GetRowShift();
+	int64_t columnShift = loops * LifeCycle.GetColumnShift();
+	if (rowShift != 0 || columnShift != 0)
+	{
+		std::vector<std::pair<int64_t, int64_t>> cells;
+		if (UnboundedTable)
+		{
+			InfiniteTable->ForEachTile([&cells](int64_t tileRow, int64_t tileColumn, const uint64_t* rows) {
+				for (int r = 0; r < SparseUniverse::TILE_SIZE; r++)
+					for (uint64_t bits = rows[r]; bits; bits &= bits - 1)
+						cells.emplace_back(tileRow * SparseUniverse::TILE_SIZE + r, tileColumn * SparseUniverse::TILE_SIZE + CountTrailingZeros(bits));
+			});
+
+			InfiniteTable->Clear();
+			for (const auto& cell : cells)
+				InfiniteTable->Set(cell.first + rowShift, cell.second + columnShift, true);
+		}
+		else
+		{
+			// only a torus lets a loop move
+			TableMatrix.Front().ForEachLiveCell([&cells](int row, int column) { cells.emplace_back(row, column); });
 
-			if (AuxTable[x][y])
-				Animations->AddBlock({ x, y });
+			int64_t width = TableMatrix.Front().GetWidth(), height = TableMatrix.Front().GetHeight();
+			TableMatrix.Clear();
+			for (const auto& cell : cells)
+				TableMatrix.Front().Set((int)(((cell.first + rowShift) % height + height) % height), (int)(((cell.second + columnShift) % width + width) % width), true);
 		}
 	}
 
-	TableMatrix = AuxTable;
+	LifeGeneration += loops * period;
+	if (UnboundedTable)
+		LifeCycle.Update(*InfiniteTable, LifeGeneration);
+	else
+		LifeCycle.Update(TableMatrix.Front(), nullptr, LifeGeneration);
+
+	std::cout << "Fast-forward: " << loops << " periods of " << period << " generations, now at generation " << LifeGeneration << std::endl;
+
+	Animations->Reset();
+	RefreshAnimations();
 }
 
+void HashLifeJump()
+{
+	if (Engine != ENGINE_LIFE)
+	{
+		std::cout << "HashLife only runs Life-like rules" << std::endl;
+		return;
+	}
+
+	if (LifeKernels::GetRule().GetReach() > 1)
+	{
+		std::cout << "HashLife only runs neighbourhoods inside the 3x3 square" << std::endl;
+		return;
+	}
+
+	if (!UnboundedTable && TableMatrix.Front().GetTopology() != TOPOLOGY_DEAD)
+	{
+		std::cout << "HashLife only runs boards with dead edges" << std::endl;
+		return;
+	}
+
+	if (UnboundedTable)
+	{
+		Universe->Load(*InfiniteTable);
+		Universe->Step(HashLifeStep);
+		Universe->Store(*InfiniteTable);
+	}
+	else
+	{
+		// the table is a window on the unbounded HashLife plane: cells that leave it during the jump are lost
+		Universe->Load(TableMatrix.Front());
+		Universe->Step(HashLifeStep);
+		Universe->Store(TableMatrix.Front());
+	}
+
+	std::cout << "HashLife: advanced 2^" << HashLifeStep << " generations, population " << Universe->GetPopulation() << std::endl;
+
+	// cells may have left the table, the states before the jump are no guide any more
+	LifeGeneration += 1LL << HashLifeStep;
+	RestartCycleDetection();
+
+	Animations->Reset();
+	RefreshAnimations();
+}
+
+// batch run of the Life-like rule: boardCount random soups of --ensemble-width x --ensemble-height cells
+// (--ensemble-density percent alive, --ensemble-seed) stepped in lockstep by EnsembleGrid for at most
+// --ensemble-generations generations, then a census of how they ended
+void RunEnsemble(int boardCount)
+{
+	if (Engine != ENGINE_LIFE)
+	{
+		std::cout << "Ensembles only run Life-like rules" << std::endl;
+		return;
+	}
+
+	int width = std::min(std::max(Options::GetInt("ensemble-width", 32), 1), 4096);
+	int height = std::min(std::max(Options::GetInt("ensemble-height", 32), 1), 4096);
+	int generations = std::max(Options::GetInt("ensemble-generations", 1000), 0);
+	int density = std::min(std::max(Options::GetInt("ensemble-density", 50), 0), 100);
+	int seed = Options::GetInt("ensemble-seed", 1);
+
+	EnsembleGrid ensemble;
+	ensemble.Resize(boardCount, width, height);
+	ensemble.Randomize((uint64_t)seed, density / 100.0);
+
+	std::cout << "Ensemble: " << ensemble.GetBoardCount() << " boards of " << width << "x" << height << ", " << density << "% soups of " << RuleName
+			  << ", kernel " << LifeKernels::GetName(LifeKernels::GetSelected()) << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	long long run = ensemble.Run(generations, StepWorkers);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "  " << run << " generations in " << seconds << " s, " << (double)ensemble.GetBoardCount() * run / std::max(seconds, 1e-9) / 1e6
+			  << " M board-generations/s" << std::endl;
+
+	// census: how the boards ended, and the one that took longest to settle
+	int stillLifes = 0, oscillators = 0, empty = 0;
+	int longest = -1;
+	std::vector<int> populations;
+	ensemble.GetPopulations(populations);
+	for (int board = 0; board < ensemble.GetBoardCount(); board++)
+	{
+		if (!ensemble.IsSettled(board))
+			continue;
+
+		if (populations[board] == 0)
+			empty++;
+		else if (ensemble.GetSettledPeriod(board) == 1)
+			stillLifes++;
+		else
+			oscillators++;
+
+		if (longest < 0 || ensemble.GetSettledGeneration(board) > ensemble.GetSettledGeneration(longest))
+			longest = board;
+	}
+
+	long long total = 0;
+	for (int population : populations)
+		total += population;
+
+	std::cout << "  died out: " << empty << ", still lifes: " << stillLifes << ", period 2: " << oscillators << ", still running: " << ensemble.GetRunningCount() << std::endl;
+	std::cout << "  population: min " << *std::min_element(populations.begin(), populations.end()) << ", average " << (double)total / populations.size()
+			  << ", max " << *std::max_element(populations.begin(), populations.end()) << std::endl;
+	if (longest >= 0)
+		std::cout << "  longest to settle: board " << longest << ", from generation " << ensemble.GetSettledGeneration(longest) << std::endl;
+}
+
+// census of the Life-like rule: soups [--soup-first, --soup-first + soupCount) of --soup-seed, --soup-size
+// squares run on the unbounded plane for at most --soup-generations generations, by SoupSearch on every core
+void RunSoupSearch(int soupCount)
+{
+	if (Engine != ENGINE_LIFE)
+	{
+		std::cout << "Soup searches only run Life-like rules" << std::endl;
+		return;
+	}
+
+	SoupSearch search;
+	search.SetSoupSize(Options::GetInt("soup-size", 16));
+	search.SetMaxGenerations(Options::GetInt("soup-generations", 10000));
+	int seed = Options::GetInt("soup-seed", 1);
+	int firstSoup = std::max(Options::GetInt("soup-first", 0), 0);
+
+	std::cout << "Soup search: soups " << firstSoup << " to " << (long long)firstSoup + soupCount - 1 << " of seed " << seed << ", " << search.GetSoupSize() << "x"
+			  << search.GetSoupSize() << " of " << RuleName << " on " << StepWorkers->GetThreadCount() << " threads" << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	search.Run((uint64_t)seed, firstSoup, soupCount, StepWorkers);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "  " << search.GetSoupCount() << " soups in " << seconds << " s, " << search.GetSoupCount() / std::max(seconds, 1e-9) << " soups/s, "
+			  << search.GetObjectCount() << " objects, " << search.GetUnsettledCount() << " soups unsettled" << std::endl;
+
+	// object, count and the first soup that left it
+	std::vector<std::pair<std::string, SoupSearch::CensusEntry>> rows;
+	search.GetCensusByCount(rows);
+	for (const auto& row : rows)
+		std::cout << "  " << row.first << " " << row.second.Count << " (soup " << row.second.FirstSoup << ")" << std::endl;
+}
+
+void RefreshAnimations()
+{
+	if (UnboundedTable)
+	{
+		int RowBegin, RowEnd, ColumnBegin, ColumnEnd;
+		GetVisibleCells(RowBegin, RowEnd, ColumnBegin, ColumnEnd);
+		InfiniteTable->ForEachLiveCell(RowBegin, RowEnd, ColumnBegin, ColumnEnd, [](int64_t x, int64_t y) { Animations->AddBlock({ (int)x, (int)y }); });
+		return;
+	}
+
+	if (Engine == ENGINE_GENERATIONS)
+	{
+		GenerationsTable.ForEachLiveCell([](int x, int y, int state) { Animations->AddBlock({ x, y }, state); });
+		return;
+	}
+
+	if (Engine == ENGINE_LARGER_THAN_LIFE)
+	{
+		LargerTable.ForEachLiveCell([](int x, int y) { Animations->AddBlock({ x, y }); });
+		return;
+	}
+
+	if (Engine == ENGINE_ELEMENTARY)
+	{
+		ElementaryTable.ForEachLiveCell([](int x, int y) { Animations->AddBlock({ x, y }); });
+		return;
+	}
+
+	if (Engine == ENGINE_VOXEL)
+	{
+		VoxelTable.ForEachLiveCell(VoxelSlice, [](int x, int y) { Animations->AddBlock({ x, y }); });
+		return;
+	}
+
+	if (Engine == ENGINE_WIREWORLD)
+	{
+		WireTable.ForEachLiveCell([](int x, int y, int state) { Animations->AddBlock({ x, y }, state); });
+		return;
+	}
+
+	if (Engine == ENGINE_LENIA)
+	{
+		// full cells black, fading ones lighter
+		LeniaTable.ForEachLiveCell([](int x, int y, float value) {
+			Animations->AddBlock({ x, y }, std::min(std::max(1 + (int)((1.0f - value) * LENIA_SHADES), 1), LENIA_SHADES));
+		});
+		return;
+	}
+
+	TableMatrix.Front().ForEachLiveCell([](int x, int y) { Animations->AddBlock({ x, y }); });
+}
+
+// cells covered by the window
+void GetVisibleCells(int& rowBegin, int& rowEnd, int& columnBegin, int& columnEnd)
+{
+	rowBegin = (int)std::floor(-TableUpY / SquareSize);
+	rowEnd = (int)std::floor(((float)SCR_HEIGHT - TableUpY) / SquareSize) + 1;
+	columnBegin = (int)std::floor(-TableUpX / SquareSize);
+	columnEnd = (int)std::floor(((float)SCR_WIDTH - TableUpX) / SquareSize) + 1;
+}
+
+// after a pan/zoom: squares that stayed on screen keep their animation, the ones that came into view are added
+void SyncVisibleCells()
+{
+	if (!UnboundedTable)
+		return;
+
+	int RowBegin, RowEnd, ColumnBegin, ColumnEnd;
+	GetVisibleCells(RowBegin, RowEnd, ColumnBegin, ColumnEnd);
+	Animations->RemoveBlocksOutside(RowBegin, RowEnd, ColumnBegin, ColumnEnd);
+	RefreshAnimations();
+}
+
+// edit one cell of the bounded board of the current engine
+void SetCell(int row, int column, bool alive)
+{
+	if (Engine == ENGINE_GENERATIONS)
+		GenerationsTable.Set(row, column, alive ? 1 : 0);
+	else if (Engine == ENGINE_LARGER_THAN_LIFE)
+		LargerTable.Set(row, column, alive);
+	else if (Engine == ENGINE_WIREWORLD)
+	{
+		// Left Shift places electron heads, on a conductor or not
+		EWireState state = !alive ? WIRE_EMPTY : (IsLeftShiftPressed ? WIRE_HEAD : WIRE_CONDUCTOR);
+		WireTable.Set(row, column, state);
+		if (alive)
+			Animations->AddBlock({ row, column }, state);
+	}
+	else if (Engine == ENGINE_ELEMENTARY)
+	{
+		// only the current generation can be edited, whatever line the click is on
+		ElementaryTable.Set(column, alive);
+		Animations->Reset();
+		RefreshAnimations();
+	}
+	else if (Engine == ENGINE_VOXEL)
+		VoxelTable.Set(VoxelSlice, row, column, alive);
+	else if (Engine == ENGINE_LENIA)
+	{
+		// one cell is too small for a Lenia pattern, the click paints a random blob
+		LeniaTable.Brush(row, column, alive);
+		Animations->Reset();
+		RefreshAnimations();
+	}
+	else
+		TableMatrix.Front().Set(row, column, alive);
+}